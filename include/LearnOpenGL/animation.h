@@ -6,6 +6,7 @@
 #include <assimp/scene.h>
 #include <learnopengl/bone.h>
 #include <functional>
+#include <unordered_map>
 #include <learnopengl/animdata.h>
 #include <learnopengl/model_animation.h>
 
@@ -17,6 +18,18 @@ struct AssimpNodeData
 	std::vector<AssimpNodeData> children;
 };
 
+// One node of the hierarchy flattened for evaluation. Nodes are stored parents first, so a single
+// forward loop can compose global transforms; channels and offsets are resolved when the clip loads.
+struct SkeletonNode
+{
+	glm::mat4 transformation; // bind pose local transform, used when the node has no channel
+	glm::mat4 offset;         // model space to bone space, valid when boneId >= 0
+	BonePose bindPose;        // transformation split into translation, rotation and scale
+	int parent;               // index of the parent node, -1 for the root
+	int channel;              // index into the clip's bones, -1 when the node is not animated
+	int boneId;               // slot in the final bone matrices, -1 when no vertex uses the node
+};
+
 class Animation
 {
 public:
@@ -34,6 +47,7 @@ public:
 		globalTransformation = globalTransformation.Inverse();
 		ReadHeirarchyData(m_RootNode, scene->mRootNode);
 		ReadMissingBones(animation, *model);
+		FlattenHierarchy();
 	}
 
 	~Animation()
@@ -53,15 +67,45 @@ public:
 	}
 
 	
-	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
-	inline float GetDuration() { return m_Duration;}
+	inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+	inline float GetDuration() const { return m_Duration;}
 	inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
+	inline const std::vector<SkeletonNode>& GetSkeleton() const { return m_Skeleton; }
+	inline const std::vector<Bone>& GetBones() const { return m_Bones; }
+	// name of each skeleton node, in skeleton order
+	inline const std::vector<std::string>& GetNodeNames() const { return m_NodeNames; }
+
+	// skeleton node called name, or -1
+	int FindNode(const std::string& name) const
+	{
+		auto iter = std::find(m_NodeNames.begin(), m_NodeNames.end(), name);
+		return iter == m_NodeNames.end() ? -1 : static_cast<int>(iter - m_NodeNames.begin());
+	}
+
+	// for each of the given skeleton nodes, the index of the bone animating it in this clip or -1.
+	// Lets a clip drive another clip's skeleton as long as the node names match.
+	std::vector<int> MapChannels(const std::vector<std::string>& nodeNames) const
+	{
+		std::unordered_map<std::string, int> channels;
+		for (size_t i = 0; i < m_Bones.size(); i++)
+			channels.emplace(m_Bones[i].GetBoneName(), static_cast<int>(i));
+		std::vector<int> map;
+		map.reserve(nodeNames.size());
+		for (const std::string& name : nodeNames)
+		{
+			auto channel = channels.find(name);
+			map.push_back(channel != channels.end() ? channel->second : -1);
+		}
+		return map;
+	}
 	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() 
 	{ 
 		return m_BoneInfoMap;
 	}
 
 private:
+	friend class AnimationCompiler;
+
 	void ReadMissingBones(const aiAnimation* animation, Model& model)
 	{
 		int size = animation->mNumChannels;
@@ -102,10 +146,48 @@ private:
 			dest.children.push_back(newData);
 		}
 	}
+	// lays the node tree out depth first, which puts every parent before its children
+	void FlattenHierarchy()
+	{
+		std::unordered_map<std::string, int> channels;
+		for (size_t i = 0; i < m_Bones.size(); i++)
+			channels.emplace(m_Bones[i].GetBoneName(), static_cast<int>(i));
+
+		m_Skeleton.clear();
+		m_NodeNames.clear();
+		std::vector<std::pair<const AssimpNodeData*, int>> stack = { { &m_RootNode, -1 } };
+		while (!stack.empty())
+		{
+			const AssimpNodeData* node = stack.back().first;
+			int parent = stack.back().second;
+			stack.pop_back();
+
+			SkeletonNode flat;
+			flat.transformation = node->transformation;
+			flat.bindPose = BonePose::FromMatrix(node->transformation);
+			flat.offset = glm::mat4(1.0f);
+			flat.parent = parent;
+			auto channel = channels.find(node->name);
+			flat.channel = channel != channels.end() ? channel->second : -1;
+			auto info = m_BoneInfoMap.find(node->name);
+			flat.boneId = info != m_BoneInfoMap.end() ? info->second.id : -1;
+			if (info != m_BoneInfoMap.end())
+				flat.offset = info->second.offset;
+
+			int index = static_cast<int>(m_Skeleton.size());
+			m_Skeleton.push_back(flat);
+			m_NodeNames.push_back(node->name);
+			for (int i = node->childrenCount - 1; i >= 0; i--)
+				stack.push_back({ &node->children[i], index });
+		}
+	}
+
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
+	std::vector<SkeletonNode> m_Skeleton;
+	std::vector<std::string> m_NodeNames;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
 };
 
@@ -0,0 +1,447 @@
+#ifndef ANIMATION_COMPILER_H
+#define ANIMATION_COMPILER_H
+
+#include <learnopengl/animation.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// error tolerances of AnimationCompiler's key reduction
+struct AnimationCompileOptions
+{
+    float positionTolerance = 0.0005f; // model units
+    float rotationTolerance = 0.0005f; // radians
+    float scaleTolerance = 0.0005f;
+};
+
+// Turns an imported Animation into a compact binary clip, and loads such clips without Assimp.
+// Compiling drops every key that linear interpolation between its neighbours reproduces within a
+// tolerance (constant tracks shrink to a single key), then stores positions and scales as 16-bit
+// values within each track's range and rotations as 48-bit smallest-three quaternions. Loaded clips
+// are evaluated straight from the packed keys.
+class AnimationCompiler
+{
+public:
+    typedef AnimationCompileOptions Options;
+
+    struct Stats
+    {
+        size_t keysIn = 0, keysOut = 0;
+        size_t bytesIn = 0, bytesOut = 0; // key storage before, file size after
+    };
+
+    // writes the compiled form of animation to clipPath. sourcePath, when given, is the file the
+    // animation was imported from; Load can then tell when the clip is out of date.
+    static bool Compile(const Animation& animation, const std::string& clipPath, const Options& options = Options(),
+                        const std::string& sourcePath = "", Stats* stats = nullptr)
+    {
+        Header header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        if (!sourcePath.empty() && !sourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        {
+            std::cout << "ERROR::ANIMATION_COMPILER: cannot read " << sourcePath << std::endl;
+            return false;
+        }
+        header.duration = animation.m_Duration;
+        header.ticksPerSecond = static_cast<float>(animation.m_TicksPerSecond);
+        header.nodeCount = static_cast<uint32_t>(animation.m_Skeleton.size());
+        header.boneInfoCount = static_cast<uint32_t>(animation.m_BoneInfoMap.size());
+        header.boneCount = static_cast<uint32_t>(animation.m_Bones.size());
+
+        Writer out;
+        out.put(header);
+        for (size_t i = 0; i < animation.m_Skeleton.size(); i++)
+        {
+            out.putString(animation.m_NodeNames[i]);
+            out.put(static_cast<int32_t>(animation.m_Skeleton[i].parent));
+            out.put(animation.m_Skeleton[i].transformation);
+        }
+        for (const auto& info : animation.m_BoneInfoMap)
+        {
+            out.putString(info.first);
+            out.put(static_cast<int32_t>(info.second.id));
+            out.put(info.second.offset);
+        }
+
+        Stats counted;
+        for (const Bone& bone : animation.m_Bones)
+            compileBone(bone, options, out, counted);
+        counted.bytesOut = out.data.size();
+
+        std::error_code ec;
+        std::filesystem::path parent = std::filesystem::path(clipPath).parent_path();
+        if (!parent.empty())
+            std::filesystem::create_directories(parent, ec);
+        // write to a temporary file first so a crash never leaves a truncated clip behind
+        const std::string temp = clipPath + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(out.data.data(), out.data.size());
+            if (!file)
+            {
+                std::cout << "ERROR::ANIMATION_COMPILER: failed to write " << temp << std::endl;
+                return false;
+            }
+        }
+        std::filesystem::rename(temp, clipPath, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temp, ec);
+            std::cout << "ERROR::ANIMATION_COMPILER: failed to write " << clipPath << std::endl;
+            return false;
+        }
+        if (stats)
+            *stats = counted;
+        return true;
+    }
+
+    // reads a compiled clip into animation. With a sourcePath, a clip compiled from a different
+    // version of that file is rejected.
+    static bool Load(const std::string& clipPath, Animation& animation, const std::string& sourcePath = "")
+    {
+        std::ifstream file(clipPath, std::ios::binary);
+        if (!file)
+            return false;
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        Reader in{ data.data(), data.data() + data.size() };
+
+        Header header;
+        if (!in.get(header) || header.magic != MAGIC || header.version != VERSION)
+            return false;
+        if (!sourcePath.empty())
+        {
+            uint64_t size;
+            int64_t time;
+            if (!sourceStamp(sourcePath, size, time) || size != header.sourceSize || time != header.sourceTime)
+                return false;
+        }
+
+        Animation loaded;
+        loaded.m_Duration = header.duration;
+        loaded.m_TicksPerSecond = static_cast<int>(header.ticksPerSecond);
+
+        // the hierarchy, stored parents first; a corrupt count must not size the arrays below
+        const size_t nodeRecordSize = sizeof(uint32_t) + sizeof(int32_t) + sizeof(glm::mat4);
+        if (static_cast<size_t>(in.end - in.next) / nodeRecordSize < header.nodeCount)
+            return fail(clipPath);
+        std::vector<std::string> names(header.nodeCount);
+        std::vector<int32_t> parents(header.nodeCount);
+        std::vector<glm::mat4> transforms(header.nodeCount);
+        std::vector<std::vector<int>> children(header.nodeCount);
+        for (uint32_t i = 0; i < header.nodeCount; i++)
+        {
+            if (!in.getString(names[i]) || !in.get(parents[i]) || !in.get(transforms[i]))
+                return fail(clipPath);
+            if ((i == 0) != (parents[i] < 0) || parents[i] >= static_cast<int32_t>(i))
+                return fail(clipPath);
+            if (i > 0)
+                children[parents[i]].push_back(static_cast<int>(i));
+        }
+        if (header.nodeCount > 0)
+        {
+            std::function<void(AssimpNodeData&, int)> build = [&](AssimpNodeData& node, int index) {
+                node.name = names[index];
+                node.transformation = transforms[index];
+                node.childrenCount = static_cast<int>(children[index].size());
+                node.children.resize(children[index].size());
+                for (size_t c = 0; c < children[index].size(); c++)
+                    build(node.children[c], children[index][c]);
+            };
+            build(loaded.m_RootNode, 0);
+        }
+
+        for (uint32_t i = 0; i < header.boneInfoCount; i++)
+        {
+            std::string name;
+            int32_t id;
+            BoneInfo info;
+            if (!in.getString(name) || !in.get(id) || !in.get(info.offset))
+                return fail(clipPath);
+            info.id = id;
+            loaded.m_BoneInfoMap[name] = info;
+        }
+
+        loaded.m_Bones.reserve(header.boneCount);
+        for (uint32_t i = 0; i < header.boneCount; i++)
+            if (!loadBone(in, loaded.m_Bones))
+                return fail(clipPath);
+
+        loaded.FlattenHierarchy();
+        animation = loaded;
+        return true;
+    }
+
+    // loads clipPath if it was compiled from the current animationPath; otherwise imports
+    // animationPath through Assimp, compiles it to clipPath and uses the result
+    static bool LoadOrCompile(const std::string& animationPath, Model* model, const std::string& clipPath, Animation& animation,
+                              const Options& options = Options())
+    {
+        if (Load(clipPath, animation, animationPath))
+            return true;
+        if (!std::filesystem::exists(animationPath))
+        {
+            std::cout << "ERROR::ANIMATION_COMPILER: " << animationPath << " not found" << std::endl;
+            return false;
+        }
+        Animation imported(animationPath, model);
+        if (Compile(imported, clipPath, options, animationPath) && Load(clipPath, animation, animationPath))
+            return true;
+        animation = imported;
+        return true;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x414E474C; // "LGNA"
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic, version;
+        uint64_t sourceSize;
+        int64_t  sourceTime;
+        float    duration, ticksPerSecond;
+        uint32_t nodeCount, boneInfoCount, boneCount, padding;
+    };
+
+    struct Writer
+    {
+        std::vector<char> data;
+
+        template <typename T>
+        void put(const T& value) { putBytes(&value, sizeof(T)); }
+        void putBytes(const void* bytes, size_t size)
+        {
+            const char* begin = static_cast<const char*>(bytes);
+            data.insert(data.end(), begin, begin + size);
+        }
+        void putString(const std::string& text)
+        {
+            put(static_cast<uint32_t>(text.size()));
+            putBytes(text.data(), text.size());
+        }
+        template <typename T>
+        void putArray(const std::vector<T>& values)
+        {
+            put(static_cast<uint32_t>(values.size()));
+            putBytes(values.data(), values.size() * sizeof(T));
+        }
+    };
+
+    // bounds-checked reads; every get fails once the data runs out
+    struct Reader
+    {
+        const char* next;
+        const char* end;
+
+        template <typename T>
+        bool get(T& value) { return getBytes(&value, sizeof(T)); }
+        bool getBytes(void* bytes, size_t size)
+        {
+            if (static_cast<size_t>(end - next) < size)
+                return false;
+            std::memcpy(bytes, next, size);
+            next += size;
+            return true;
+        }
+        bool getString(std::string& text)
+        {
+            uint32_t size;
+            if (!get(size) || static_cast<size_t>(end - next) < size)
+                return false;
+            text.assign(next, size);
+            next += size;
+            return true;
+        }
+        template <typename T>
+        bool getArray(std::vector<T>& values)
+        {
+            uint32_t count;
+            if (!get(count) || static_cast<size_t>(end - next) / sizeof(T) < count)
+                return false;
+            values.resize(count);
+            return getBytes(values.data(), count * sizeof(T));
+        }
+    };
+
+    static bool fail(const std::string& clipPath)
+    {
+        std::cout << "ERROR::ANIMATION_COMPILER: " << clipPath << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    // indices of the keys worth keeping: the first, the last, and every key that linear
+    // interpolation between the kept keys around it would miss by more than tolerance. error(a, b, k)
+    // measures key k against the interpolation from key a to key b.
+    static std::vector<int> reduce(size_t count, const std::function<float(int, int, int)>& error, float tolerance)
+    {
+        std::vector<int> kept;
+        if (count == 0)
+            return kept;
+        kept.push_back(0);
+        int last = static_cast<int>(count) - 1;
+        bool constant = true;
+        for (int k = 1; k <= last && constant; k++)
+            constant = error(0, 0, k) <= tolerance;
+        if (constant)
+            return kept;
+
+        int anchor = 0;
+        for (int end = 2; end <= last; end++)
+            for (int k = anchor + 1; k < end; k++)
+                if (error(anchor, end, k) > tolerance)
+                {
+                    kept.push_back(end - 1);
+                    anchor = end - 1;
+                    break;
+                }
+        kept.push_back(last);
+        return kept;
+    }
+
+    static float factor(const std::vector<float>& times, int a, int b, int k)
+    {
+        float span = times[b] - times[a];
+        return span > 0.0f ? (times[k] - times[a]) / span : 0.0f;
+    }
+
+    // angle between two rotations; asin of the half-angle sine stays accurate for tiny angles
+    static float angleBetween(const glm::quat& a, const glm::quat& b)
+    {
+        glm::quat d = glm::inverse(a) * b;
+        return 2.0f * std::asin(std::min(1.0f, glm::length(glm::vec3(d.x, d.y, d.z))));
+    }
+
+    static int addTimes(std::vector<std::vector<float>>& arrays, const std::vector<float>& times)
+    {
+        for (size_t i = 0; i < arrays.size(); i++)
+            if (arrays[i] == times)
+                return static_cast<int>(i);
+        arrays.push_back(times);
+        return static_cast<int>(arrays.size()) - 1;
+    }
+
+    static void compileBone(const Bone& bone, const Options& options, Writer& out, Stats& stats)
+    {
+        const std::vector<float>& positionTimes = bone.GetPositionTimes();
+        const std::vector<float>& rotationTimes = bone.GetRotationTimes();
+        const std::vector<float>& scaleTimes = bone.GetScaleTimes();
+
+        std::vector<int> positions = reduce(positionTimes.size(), [&](int a, int b, int k) {
+            glm::vec3 lerped = glm::mix(bone.PositionKey(a), bone.PositionKey(b), factor(positionTimes, a, b, k));
+            return glm::length(lerped - bone.PositionKey(k));
+        }, options.positionTolerance);
+        std::vector<int> rotations = reduce(rotationTimes.size(), [&](int a, int b, int k) {
+            glm::quat slerped = glm::slerp(bone.RotationKey(a), bone.RotationKey(b), factor(rotationTimes, a, b, k));
+            return angleBetween(glm::normalize(slerped), glm::normalize(bone.RotationKey(k)));
+        }, options.rotationTolerance);
+        std::vector<int> scales = reduce(scaleTimes.size(), [&](int a, int b, int k) {
+            glm::vec3 lerped = glm::mix(bone.ScaleKey(a), bone.ScaleKey(b), factor(scaleTimes, a, b, k));
+            return glm::length(lerped - bone.ScaleKey(k));
+        }, options.scaleTolerance);
+
+        std::vector<std::vector<float>> arrays;
+        std::vector<float> times;
+        for (int k : positions)
+            times.push_back(positionTimes[k]);
+        int32_t positionArray = addTimes(arrays, times);
+        times.clear();
+        for (int k : rotations)
+            times.push_back(rotationTimes[k]);
+        int32_t rotationArray = addTimes(arrays, times);
+        times.clear();
+        for (int k : scales)
+            times.push_back(scaleTimes[k]);
+        int32_t scaleArray = addTimes(arrays, times);
+
+        glm::vec3 positionMin(0.0f), positionMax(0.0f), scaleMin(1.0f), scaleMax(1.0f);
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            glm::vec3 p = bone.PositionKey(positions[i]);
+            positionMin = i == 0 ? p : glm::min(positionMin, p);
+            positionMax = i == 0 ? p : glm::max(positionMax, p);
+        }
+        for (size_t i = 0; i < scales.size(); i++)
+        {
+            glm::vec3 s = bone.ScaleKey(scales[i]);
+            scaleMin = i == 0 ? s : glm::min(scaleMin, s);
+            scaleMax = i == 0 ? s : glm::max(scaleMax, s);
+        }
+        std::vector<uint16_t> packedPositions(positions.size() * 3), packedRotations(rotations.size() * 3), packedScales(scales.size() * 3);
+        for (size_t i = 0; i < positions.size(); i++)
+            Bone::PackVec3(bone.PositionKey(positions[i]), positionMin, positionMax - positionMin, &packedPositions[3 * i]);
+        for (size_t i = 0; i < rotations.size(); i++)
+            Bone::PackQuat(bone.RotationKey(rotations[i]), &packedRotations[3 * i]);
+        for (size_t i = 0; i < scales.size(); i++)
+            Bone::PackVec3(bone.ScaleKey(scales[i]), scaleMin, scaleMax - scaleMin, &packedScales[3 * i]);
+
+        out.putString(bone.GetBoneName());
+        out.put(static_cast<int32_t>(bone.m_ID));
+        out.put(static_cast<uint32_t>(arrays.size()));
+        for (const std::vector<float>& array : arrays)
+            out.putArray(array);
+        out.put(positionArray);
+        out.put(rotationArray);
+        out.put(scaleArray);
+        out.put(positionMin);
+        out.put(positionMax - positionMin);
+        out.put(scaleMin);
+        out.put(scaleMax - scaleMin);
+        out.putArray(packedPositions);
+        out.putArray(packedRotations);
+        out.putArray(packedScales);
+
+        stats.keysIn += positionTimes.size() + rotationTimes.size() + scaleTimes.size();
+        stats.keysOut += positions.size() + rotations.size() + scales.size();
+        for (const std::vector<float>& array : bone.m_Times)
+            stats.bytesIn += array.size() * sizeof(float);
+        stats.bytesIn += positionTimes.size() * sizeof(glm::vec3) + rotationTimes.size() * sizeof(glm::quat) + scaleTimes.size() * sizeof(glm::vec3);
+    }
+
+    static bool loadBone(Reader& in, std::vector<Bone>& bones)
+    {
+        std::string name;
+        int32_t id;
+        uint32_t arrayCount;
+        if (!in.getString(name) || !in.get(id) || !in.get(arrayCount) || arrayCount > 3)
+            return false;
+        Bone bone(name, id);
+        bone.m_Packed = true;
+        bone.m_Times.resize(arrayCount);
+        for (std::vector<float>& array : bone.m_Times)
+            if (!in.getArray(array))
+                return false;
+        int32_t positionArray, rotationArray, scaleArray;
+        if (!in.get(positionArray) || !in.get(rotationArray) || !in.get(scaleArray)
+            || !in.get(bone.m_PositionMin) || !in.get(bone.m_PositionExtent) || !in.get(bone.m_ScaleMin) || !in.get(bone.m_ScaleExtent)
+            || !in.getArray(bone.m_PackedPositions) || !in.getArray(bone.m_PackedRotations) || !in.getArray(bone.m_PackedScales))
+            return false;
+        auto valid = [&](int32_t array, const std::vector<uint16_t>& packed) {
+            return array >= 0 && array < static_cast<int32_t>(arrayCount) && packed.size() == bone.m_Times[array].size() * 3;
+        };
+        if (!valid(positionArray, bone.m_PackedPositions) || !valid(rotationArray, bone.m_PackedRotations) || !valid(scaleArray, bone.m_PackedScales))
+            return false;
+        bone.m_PositionTimes = positionArray;
+        bone.m_RotationTimes = rotationArray;
+        bone.m_ScaleTimes = scaleArray;
+        bones.push_back(std::move(bone));
+        return true;
+    }
+
+    static bool sourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(sourcePath, ec);
+        if (ec)
+            return false;
+        time = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+        return !ec;
+    }
+};
+#endif
@@ -0,0 +1,47 @@
+#ifndef ANIMATION_LOD_H
+#define ANIMATION_LOD_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/animator.h>
+#include <learnopengl/frustum.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Picks an Animator::Lod for a skinned character from the frustum and its height on screen: characters
+// outside the frustum only advance time, smaller ones sample their clips less often and, below
+// DetailPixels, leave fingers and facial bones alone.
+class AnimationLodSelector
+{
+public:
+    float FullRatePixels = 200.0f; // characters at least this many pixels tall update every frame
+    float DetailPixels = 120.0f;   // smaller characters skip their detail bones
+    unsigned int MaxInterval = 4;  // the longest wait between two samples, in frames
+
+    AnimationLodSelector(float fovY, float viewportHeight)
+        : pixelsPerUnit(viewportHeight / (2.0f * std::tan(fovY * 0.5f)))
+    {
+    }
+
+    // center and radius bound the character in world space
+    Animator::Lod Select(const Frustum& frustum, const glm::vec3& cameraPosition, const glm::vec3& center, float radius) const
+    {
+        Animator::Lod lod;
+        if (!isSphereOnFrustum(frustum, center, radius))
+        {
+            lod.visible = false;
+            return lod;
+        }
+        float pixels = 2.0f * radius * pixelsPerUnit / std::max(glm::length(center - cameraPosition), 1e-4f);
+        lod.detailBones = pixels >= DetailPixels;
+        // halving the size doubles the interval, up to MaxInterval
+        if (pixels < FullRatePixels)
+            lod.updateInterval = static_cast<unsigned int>(std::min(static_cast<float>(MaxInterval), std::ceil(FullRatePixels / pixels)));
+        return lod;
+    }
+
+private:
+    float pixelsPerUnit; // screen pixels covered by one unit at distance 1
+};
+#endif
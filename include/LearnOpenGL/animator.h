@@ -8,71 +8,434 @@
 #include <learnopengl/animation.h>
 #include <learnopengl/bone.h>
 
+// Plays clips on the skeleton of the animation it was created with. Layer 0 is the base pose;
+// higher layers are blended over it in order, either replacing it (BLEND_OVERRIDE) or adding their
+// motion relative to their first frame (BLEND_ADDITIVE), optionally limited to part of the body by
+// a per-node mask. Any layer can cross-fade to another clip. Poses are blended as local translation,
+// rotation and scale in scratch buffers and turned into matrices once, at the end.
+//
+// SetLod trades accuracy for time on characters that are small or off screen (see AnimationLodSelector):
+// the clips can be sampled only every few frames, with the pose in between interpolated towards where
+// the clips will be at the next key frame; detail bones (fingers, facial rigs) can keep their bind pose;
+// and invisible characters only advance their clocks.
 class Animator
 {
 public:
-	Animator(Animation* animation)
+	// size of the bone palette, matching MAX_BONES in the skinning shaders
+	static const int MAX_BONES = 100;
+
+	enum BlendMode
 	{
-		m_CurrentTime = 0.0;
-		m_CurrentAnimation = animation;
+		BLEND_OVERRIDE,
+		BLEND_ADDITIVE
+	};
 
-		m_FinalBoneMatrices.reserve(100);
+	// how much work an update does
+	struct Lod
+	{
+		bool visible = true;             // false: only advance time, leave the palette as it is
+		unsigned int updateInterval = 1; // sample the clips every updateInterval frames
+		bool detailBones = true;         // false: nodes in DetailMask keep their bind pose
+	};
 
-		for (int i = 0; i < 100; i++)
-			m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+	Animator(Animation* animation)
+	{
+		m_CurrentTime = 0.0;
+		m_DeltaTime = 0.0f;
+		m_CurrentAnimation = nullptr;
+		m_SkeletonSource = nullptr;
+		m_FinalBoneMatrices.assign(MAX_BONES, glm::mat4(1.0f));
+		m_Layers.resize(1);
+		PlayAnimation(animation);
 	}
 
 	void UpdateAnimation(float dt)
 	{
 		m_DeltaTime = dt;
-		if (m_CurrentAnimation)
+		if (!m_CurrentAnimation)
+			return;
+		for (Layer& layer : m_Layers)
+		{
+			Advance(layer.current, dt);
+			if (layer.previous.clip)
+			{
+				Advance(layer.previous, dt);
+				layer.fadeElapsed += dt;
+				if (layer.fadeElapsed >= layer.fadeDuration)
+					layer.previous.clip = nullptr;
+			}
+		}
+		m_CurrentTime = m_Layers[0].current.time;
+		if (!m_Lod.visible)
 		{
-			m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
-			m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+			// off screen only the clocks run; the pose is rebuilt when the character is seen again
+			m_PoseStale = true;
+			m_LodSteps = 0;
+			return;
 		}
+		if (m_Lod.updateInterval <= 1)
+		{
+			m_LodSteps = 0;
+			CalculateBoneTransforms();
+			return;
+		}
+		UpdateReducedRate(dt);
 	}
 
+	// phase staggers the key frames of characters sharing an update interval, e.g. their index
+	void SetLod(const Lod& lod, unsigned int phase = 0)
+	{
+		if (lod.updateInterval != m_Lod.updateInterval || lod.detailBones != m_Lod.detailBones)
+			m_LodSteps = 0;
+		m_Lod = lod;
+		m_LodPhase = phase;
+	}
+
+	const Lod& GetLod() const
+	{
+		return m_Lod;
+	}
+
+	// switches the base layer to pAnimation at once. The first animation played also provides the
+	// skeleton every later clip is mapped onto by node name.
 	void PlayAnimation(Animation* pAnimation)
 	{
+		if (!m_SkeletonSource && pAnimation)
+		{
+			m_SkeletonSource = pAnimation;
+			m_DetailMask = DetailMask();
+		}
 		m_CurrentAnimation = pAnimation;
 		m_CurrentTime = 0.0f;
+		Layer& base = m_Layers[0];
+		Start(base.current, pAnimation);
+		base.previous.clip = nullptr;
 	}
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+	// blends a layer from its current clip to pAnimation over the given number of seconds
+	void CrossFade(Animation* pAnimation, float seconds, int layer = 0)
 	{
-		std::string nodeName = node->name;
-		glm::mat4 nodeTransform = node->transformation;
-
-		Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
-
-		if (Bone)
+		if (layer >= static_cast<int>(m_Layers.size()))
+			return;
+		if (!m_SkeletonSource || !m_Layers[layer].current.clip || seconds <= 0.0f)
 		{
-			Bone->Update(m_CurrentTime);
-			nodeTransform = Bone->GetLocalTransform();
+			if (layer == 0)
+				PlayAnimation(pAnimation);
+			else
+				StartLayer(m_Layers[layer], pAnimation);
+			return;
 		}
+		Layer& target = m_Layers[layer];
+		target.previous = std::move(target.current);
+		StartLayer(target, pAnimation);
+		target.fadeDuration = seconds;
+		target.fadeElapsed = 0.0f;
+		if (layer == 0)
+			m_CurrentAnimation = pAnimation;
+	}
+
+	// plays pAnimation on layer (1 or higher) over the layers below it. mask holds a weight per
+	// skeleton node (see BoneMask); an empty mask covers the whole body.
+	void SetLayer(int layer, Animation* pAnimation, BlendMode mode, float weight = 1.0f, std::vector<float> mask = {})
+	{
+		if (layer < 1)
+			return;
+		if (layer >= static_cast<int>(m_Layers.size()))
+			m_Layers.resize(layer + 1);
+		Layer& target = m_Layers[layer];
+		target.mode = mode;
+		StartLayer(target, pAnimation);
+		target.previous.clip = nullptr;
+		target.weight = weight;
+		target.mask = std::move(mask);
+	}
+
+	void SetLayerWeight(int layer, float weight)
+	{
+		if (layer >= 0 && layer < static_cast<int>(m_Layers.size()))
+			m_Layers[layer].weight = weight;
+	}
+
+	void ClearLayer(int layer)
+	{
+		if (layer >= 1 && layer < static_cast<int>(m_Layers.size()))
+			m_Layers[layer] = Layer();
+	}
 
-		glm::mat4 globalTransformation = parentTransform * nodeTransform;
+	// mask weighting the named node and everything below it with 1 and the rest with 0,
+	// e.g. BoneMask("mixamorig_Spine1") for an upper body layer
+	std::vector<float> BoneMask(const std::string& rootBone) const
+	{
+		if (!m_SkeletonSource)
+			return {};
+		const std::vector<SkeletonNode>& skeleton = m_SkeletonSource->GetSkeleton();
+		const std::vector<std::string>& names = m_SkeletonSource->GetNodeNames();
+		std::vector<float> mask(skeleton.size(), 0.0f);
+		for (size_t i = 0; i < skeleton.size(); i++)
+			if (names[i] == rootBone || (skeleton[i].parent >= 0 && mask[skeleton[i].parent] > 0.0f))
+				mask[i] = 1.0f;
+		return mask;
+	}
 
-		auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-		if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+	// nodes hanging off a node with at least minBranches children in chains of at most maxChainLength
+	// nodes: fingers below a hand, bones of a facial rig below a head. The default for SetLod's detailBones.
+	std::vector<float> DetailMask(int minBranches = 4, int maxChainLength = 4) const
+	{
+		if (!m_SkeletonSource)
+			return {};
+		const std::vector<SkeletonNode>& skeleton = m_SkeletonSource->GetSkeleton();
+		std::vector<int> height(skeleton.size(), 0), branches(skeleton.size(), 0);
+		for (size_t i = skeleton.size(); i-- > 0; )
 		{
-			int index = boneInfoMap[nodeName].id;
-			glm::mat4 offset = boneInfoMap[nodeName].offset;
-			m_FinalBoneMatrices[index] = globalTransformation * offset;
+			int parent = skeleton[i].parent;
+			if (parent < 0)
+				continue;
+			height[parent] = std::max(height[parent], height[i] + 1);
+			branches[parent]++;
 		}
+		std::vector<float> mask(skeleton.size(), 0.0f);
+		for (size_t i = 0; i < skeleton.size(); i++)
+		{
+			int parent = skeleton[i].parent;
+			if (parent >= 0 && (mask[parent] > 0.0f || (branches[parent] >= minBranches && height[i] < maxChainLength)))
+				mask[i] = 1.0f;
+		}
+		return mask;
+	}
+
+	// replaces the nodes skipped when SetLod turns detailBones off
+	void SetDetailMask(std::vector<float> mask)
+	{
+		m_DetailMask = std::move(mask);
+	}
 
-		for (int i = 0; i < node->childrenCount; i++)
-			CalculateBoneTransform(&node->children[i], globalTransformation);
+	// blends the layers into m_Pose, then composes matrices in one pass over the flattened
+	// skeleton; parents precede their children, so each parent transform is final when needed
+	void CalculateBoneTransforms()
+	{
+		BlendLayers(0.0f);
+		ComposePalette();
 	}
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 	{
 		return m_FinalBoneMatrices;
 	}
 
+	// local pose of every skeleton node after the last update
+	const std::vector<BonePose>& GetPose() const
+	{
+		return m_Pose;
+	}
+
 private:
+	// a clip being played: its time, key cursors and which of its bones drives each skeleton node
+	struct ClipState
+	{
+		Animation* clip = nullptr;
+		float time = 0.0f;
+		std::vector<int> channels;
+		std::vector<KeyCursor> cursors;
+		std::vector<BonePose> reference; // first frame, on additive layers
+	};
+
+	struct Layer
+	{
+		ClipState current;
+		ClipState previous; // clip faded out of, while fading
+		float fadeDuration = 0.0f;
+		float fadeElapsed = 0.0f;
+		BlendMode mode = BLEND_OVERRIDE;
+		float weight = 1.0f;
+		std::vector<float> mask;
+	};
+
+	void Start(ClipState& state, Animation* clip)
+	{
+		// a reduced rate segment heading for the old clip's pose would end in a jump
+		m_LodSteps = 0;
+		state.clip = clip;
+		state.time = 0.0f;
+		if (!clip || !m_SkeletonSource)
+			return;
+		if (clip == m_SkeletonSource)
+		{
+			const std::vector<SkeletonNode>& skeleton = clip->GetSkeleton();
+			state.channels.resize(skeleton.size());
+			for (size_t i = 0; i < skeleton.size(); i++)
+				state.channels[i] = skeleton[i].channel;
+		}
+		else
+			state.channels = clip->MapChannels(m_SkeletonSource->GetNodeNames());
+		state.cursors.assign(clip->GetBones().size(), KeyCursor());
+	}
+
+	// starts clip on the layer; on an additive layer its first frame becomes what its motion is measured against
+	void StartLayer(Layer& layer, Animation* clip)
+	{
+		Start(layer.current, clip);
+		layer.current.reference.clear();
+		if (layer.mode == BLEND_ADDITIVE && clip && m_SkeletonSource)
+		{
+			ClipState first = layer.current;
+			SamplePose(first, layer.current.reference);
+		}
+	}
+
+	static void Advance(ClipState& state, float dt)
+	{
+		if (!state.clip)
+			return;
+		state.time += state.clip->GetTicksPerSecond() * dt;
+		state.time = fmod(state.time, state.clip->GetDuration());
+	}
+
+	// samples the clip ahead seconds past its current time; without allBones, detail nodes are left
+	// in their bind pose when the level of detail asks for it
+	void SamplePose(ClipState& state, std::vector<BonePose>& pose, float ahead = 0.0f, bool allBones = true) const
+	{
+		const std::vector<SkeletonNode>& skeleton = m_SkeletonSource->GetSkeleton();
+		const std::vector<Bone>& bones = state.clip->GetBones();
+		float time = state.time;
+		if (ahead > 0.0f)
+			time = fmod(time + state.clip->GetTicksPerSecond() * ahead, state.clip->GetDuration());
+		bool skipDetail = !allBones && SkipsDetail();
+		pose.resize(skeleton.size());
+		for (size_t i = 0; i < skeleton.size(); i++)
+		{
+			int channel = state.channels[i];
+			if (channel < 0 || (skipDetail && m_DetailMask[i] > 0.0f))
+				pose[i] = skeleton[i].bindPose;
+			else
+				pose[i] = bones[channel].Sample(time, state.cursors[channel]);
+		}
+	}
+
+	bool SkipsDetail() const
+	{
+		return !m_Lod.detailBones && m_DetailMask.size() == m_SkeletonSource->GetSkeleton().size();
+	}
+
+	// the layer blend of CalculateBoneTransforms, for the clips as they will be ahead seconds from now
+	void BlendLayers(float ahead)
+	{
+		for (size_t l = 0; l < m_Layers.size(); l++)
+		{
+			Layer& layer = m_Layers[l];
+			if (!layer.current.clip || (l > 0 && layer.weight <= 0.0f))
+				continue;
+			// the base layer samples straight into the pose, others into scratch
+			std::vector<BonePose>& pose = l == 0 ? m_Pose : m_LayerPose;
+			SamplePose(layer.current, pose, ahead, false);
+			const std::vector<BonePose>* reference = &layer.current.reference;
+			if (layer.previous.clip)
+			{
+				SamplePose(layer.previous, m_FadePose, ahead, false);
+				float t = std::min((layer.fadeElapsed + ahead) / layer.fadeDuration, 1.0f);
+				for (size_t i = 0; i < pose.size(); i++)
+					pose[i] = BonePose::Mix(m_FadePose[i], pose[i], t);
+				// an additive layer fades between the two clips' references as well
+				const std::vector<BonePose>& from = layer.previous.reference;
+				if (layer.mode == BLEND_ADDITIVE && from.size() == pose.size() && reference->size() == pose.size())
+				{
+					m_FadeReference.resize(pose.size());
+					for (size_t i = 0; i < pose.size(); i++)
+						m_FadeReference[i] = BonePose::Mix(from[i], (*reference)[i], t);
+					reference = &m_FadeReference;
+				}
+			}
+			if (l > 0)
+				ApplyLayer(layer, *reference);
+		}
+		m_PoseStale = false;
+	}
+
+	// samples the clips once per segment of updateInterval frames, at the time the segment ends, and
+	// moves the shown pose towards that sample frame by frame
+	void UpdateReducedRate(float dt)
+	{
+		if (m_LodStep >= m_LodSteps)
+		{
+			if (m_PoseStale || m_Pose.empty())
+				BlendLayers(0.0f);
+			// after a change the first segment is shortened by the phase, staggering key frames
+			unsigned int interval = m_Lod.updateInterval;
+			m_LodSteps = m_LodSteps == 0 ? 1 + m_LodPhase % interval : interval;
+			m_LodStep = 0;
+			m_LodFrom = m_Pose;
+			BlendLayers(dt * (m_LodSteps - 1));
+			m_LodTo = m_Pose;
+		}
+		m_LodStep++;
+		float t = static_cast<float>(m_LodStep) / m_LodSteps;
+		for (size_t i = 0; i < m_Pose.size(); i++)
+			m_Pose[i] = BonePose::Mix(m_LodFrom[i], m_LodTo[i], t);
+		ComposePalette();
+	}
+
+	void ComposePalette()
+	{
+		const std::vector<SkeletonNode>& skeleton = m_SkeletonSource->GetSkeleton();
+		m_GlobalTransforms.resize(skeleton.size());
+		for (size_t i = 0; i < skeleton.size(); i++)
+		{
+			const SkeletonNode& node = skeleton[i];
+			glm::mat4 nodeTransform = m_Pose[i].ToMatrix();
+
+			glm::mat4& globalTransformation = m_GlobalTransforms[i];
+			globalTransformation = node.parent < 0 ? nodeTransform : m_GlobalTransforms[node.parent] * nodeTransform;
+
+			if (node.boneId >= 0 && node.boneId < static_cast<int>(m_FinalBoneMatrices.size()))
+				m_FinalBoneMatrices[node.boneId] = globalTransformation * node.offset;
+		}
+	}
+
+	// blends m_LayerPose into m_Pose; an additive layer is measured against reference
+	void ApplyLayer(const Layer& layer, const std::vector<BonePose>& reference)
+	{
+		if (layer.mode == BLEND_ADDITIVE && reference.size() != m_Pose.size())
+			return;
+		const std::vector<int>& channels = layer.current.channels;
+		bool skipDetail = SkipsDetail();
+		for (size_t i = 0; i < m_Pose.size(); i++)
+		{
+			float weight = layer.weight * (layer.mask.empty() ? 1.0f : layer.mask[i]);
+			// nodes the layer's clip does not animate keep the pose below
+			if (weight <= 0.0f || (channels[i] < 0 && (!layer.previous.clip || layer.previous.channels[i] < 0)))
+				continue;
+			if (skipDetail && m_DetailMask[i] > 0.0f)
+				continue;
+			BonePose& pose = m_Pose[i];
+			const BonePose& layerPose = m_LayerPose[i];
+			if (layer.mode == BLEND_OVERRIDE)
+			{
+				pose = BonePose::Mix(pose, layerPose, weight);
+				continue;
+			}
+			const BonePose& first = reference[i];
+			pose.translation += (layerPose.translation - first.translation) * weight;
+			pose.scale *= glm::mix(glm::vec3(1.0f), layerPose.scale / first.scale, weight);
+			BonePose delta;
+			delta.rotation = glm::inverse(first.rotation) * layerPose.rotation;
+			pose.rotation = glm::normalize(pose.rotation * BonePose::Mix(BonePose(), delta, weight).rotation);
+		}
+	}
+
 	std::vector<glm::mat4> m_FinalBoneMatrices;
+	std::vector<glm::mat4> m_GlobalTransforms; // per skeleton node, scratch for CalculateBoneTransforms
+	std::vector<BonePose> m_Pose;              // blended local pose per skeleton node
+	std::vector<BonePose> m_LayerPose;         // scratch: the layer being blended
+	std::vector<BonePose> m_FadePose;          // scratch: the clip being faded out of
+	std::vector<BonePose> m_FadeReference;     // scratch: an additive layer's reference while fading
+	std::vector<BonePose> m_LodFrom, m_LodTo;  // ends of the current reduced rate segment
+	std::vector<float> m_DetailMask;
+	std::vector<Layer> m_Layers;
+	Lod m_Lod;
+	unsigned int m_LodPhase = 0;
+	unsigned int m_LodStep = 0;  // frames shown of the current segment
+	unsigned int m_LodSteps = 0; // frames in the current segment, 0 to start a new one at once
+	bool m_PoseStale = true;     // m_Pose predates frames spent off screen
+	Animation* m_SkeletonSource;
 	Animation* m_CurrentAnimation;
 	float m_CurrentTime;
 	float m_DeltaTime;
@@ -5,6 +5,9 @@
 #include <vector>
 #include <assimp/scene.h>
 #include <list>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
@@ -28,6 +31,59 @@ struct KeyScale
 	float timeStamp;
 };
 
+// Local translation, rotation and scale of one node
+struct BonePose
+{
+	glm::vec3 translation = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+
+	// splits a transform without shear into its parts
+	static BonePose FromMatrix(const glm::mat4& m)
+	{
+		BonePose pose;
+		pose.translation = glm::vec3(m[3]);
+		pose.scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+		glm::mat3 rotation(glm::vec3(m[0]) / pose.scale.x, glm::vec3(m[1]) / pose.scale.y, glm::vec3(m[2]) / pose.scale.z);
+		pose.rotation = glm::normalize(glm::quat_cast(rotation));
+		return pose;
+	}
+
+	// interpolation from a (t = 0) to b (t = 1); rotations take the shorter way round
+	static BonePose Mix(const BonePose& a, const BonePose& b, float t)
+	{
+		BonePose pose;
+		pose.translation = glm::mix(a.translation, b.translation, t);
+		pose.scale = glm::mix(a.scale, b.scale, t);
+		glm::quat to = glm::dot(a.rotation, b.rotation) < 0.0f ? -b.rotation : b.rotation;
+		pose.rotation = glm::normalize(glm::quat(
+			glm::mix(a.rotation.w, to.w, t), glm::mix(a.rotation.x, to.x, t),
+			glm::mix(a.rotation.y, to.y, t), glm::mix(a.rotation.z, to.z, t)));
+		return pose;
+	}
+
+	// same as translate * toMat4(rotation) * scale, without the matrix products
+	glm::mat4 ToMatrix() const
+	{
+		glm::mat4 m = glm::toMat4(rotation);
+		m[0] *= scale.x;
+		m[1] *= scale.y;
+		m[2] *= scale.z;
+		m[3] = glm::vec4(translation, 1.0f);
+		return m;
+	}
+};
+
+// Where the last key lookups of a channel ended. Playback moving forward finds its next keys
+// from here in a step or two; anything else falls back to a binary search. Each animator keeps
+// its own cursors, so one clip can be sampled by many characters at once.
+struct KeyCursor
+{
+	int position = 0;
+	int rotation = 0;
+	int scale = 0;
+};
+
 class Bone
 {
 public:
@@ -37,149 +93,232 @@ public:
 		m_ID(ID),
 		m_LocalTransform(1.0f)
 	{
-		m_NumPositions = channel->mNumPositionKeys;
+		std::vector<float> times;
 
-		for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex)
+		for (unsigned int positionIndex = 0; positionIndex < channel->mNumPositionKeys; ++positionIndex)
 		{
-			aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
-			float timeStamp = channel->mPositionKeys[positionIndex].mTime;
-			KeyPosition data;
-			data.position = AssimpGLMHelpers::GetGLMVec(aiPosition);
-			data.timeStamp = timeStamp;
-			m_Positions.push_back(data);
+			times.push_back(static_cast<float>(channel->mPositionKeys[positionIndex].mTime));
+			m_Positions.push_back(AssimpGLMHelpers::GetGLMVec(channel->mPositionKeys[positionIndex].mValue));
 		}
+		m_PositionTimes = AddTimes(times);
 
-		m_NumRotations = channel->mNumRotationKeys;
-		for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex)
+		times.clear();
+		for (unsigned int rotationIndex = 0; rotationIndex < channel->mNumRotationKeys; ++rotationIndex)
 		{
-			aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
-			float timeStamp = channel->mRotationKeys[rotationIndex].mTime;
-			KeyRotation data;
-			data.orientation = AssimpGLMHelpers::GetGLMQuat(aiOrientation);
-			data.timeStamp = timeStamp;
-			m_Rotations.push_back(data);
+			times.push_back(static_cast<float>(channel->mRotationKeys[rotationIndex].mTime));
+			m_Rotations.push_back(AssimpGLMHelpers::GetGLMQuat(channel->mRotationKeys[rotationIndex].mValue));
 		}
+		m_RotationTimes = AddTimes(times);
 
-		m_NumScalings = channel->mNumScalingKeys;
-		for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex)
+		times.clear();
+		for (unsigned int keyIndex = 0; keyIndex < channel->mNumScalingKeys; ++keyIndex)
 		{
-			aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
-			float timeStamp = channel->mScalingKeys[keyIndex].mTime;
-			KeyScale data;
-			data.scale = AssimpGLMHelpers::GetGLMVec(scale);
-			data.timeStamp = timeStamp;
-			m_Scales.push_back(data);
+			times.push_back(static_cast<float>(channel->mScalingKeys[keyIndex].mTime));
+			m_Scales.push_back(AssimpGLMHelpers::GetGLMVec(channel->mScalingKeys[keyIndex].mValue));
 		}
+		m_ScaleTimes = AddTimes(times);
 	}
-	
+
 	void Update(float animationTime)
 	{
-		glm::mat4 translation = InterpolatePosition(animationTime);
-		glm::mat4 rotation = InterpolateRotation(animationTime);
-		glm::mat4 scale = InterpolateScaling(animationTime);
-		m_LocalTransform = translation * rotation * scale;
+		m_LocalTransform = Sample(animationTime, m_Cursor).ToMatrix();
 	}
-	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
-	std::string GetBoneName() const { return m_Name; }
-	int GetBoneID() { return m_ID; }
-	
 
-
-	int GetPositionIndex(float animationTime)
+	// interpolated local transform at animationTime; cursor is the caller's lookup state for this channel
+	BonePose Sample(float animationTime, KeyCursor& cursor) const
 	{
-		for (int index = 0; index < m_NumPositions - 1; ++index)
+		BonePose pose;
+		const std::vector<float>& positionTimes = m_Times[m_PositionTimes];
+		if (positionTimes.size() == 1)
+			pose.translation = PositionKey(0);
+		else if (!positionTimes.empty())
+		{
+			int p0Index = FindKey(positionTimes, animationTime, cursor.position);
+			float scaleFactor = GetScaleFactor(positionTimes[p0Index], positionTimes[p0Index + 1], animationTime);
+			pose.translation = glm::mix(PositionKey(p0Index), PositionKey(p0Index + 1), scaleFactor);
+		}
+
+		const std::vector<float>& rotationTimes = m_Times[m_RotationTimes];
+		if (rotationTimes.size() == 1)
+			pose.rotation = glm::normalize(RotationKey(0));
+		else if (!rotationTimes.empty())
+		{
+			int p0Index = FindKey(rotationTimes, animationTime, cursor.rotation);
+			float scaleFactor = GetScaleFactor(rotationTimes[p0Index], rotationTimes[p0Index + 1], animationTime);
+			pose.rotation = glm::normalize(glm::slerp(RotationKey(p0Index), RotationKey(p0Index + 1), scaleFactor));
+		}
+
+		const std::vector<float>& scaleTimes = m_Times[m_ScaleTimes];
+		if (scaleTimes.size() == 1)
+			pose.scale = ScaleKey(0);
+		else if (!scaleTimes.empty())
 		{
-			if (animationTime < m_Positions[index + 1].timeStamp)
-				return index;
+			int p0Index = FindKey(scaleTimes, animationTime, cursor.scale);
+			float scaleFactor = GetScaleFactor(scaleTimes[p0Index], scaleTimes[p0Index + 1], animationTime);
+			pose.scale = glm::mix(ScaleKey(p0Index), ScaleKey(p0Index + 1), scaleFactor);
 		}
-		assert(0);
+		return pose;
 	}
 
-	int GetRotationIndex(float animationTime)
+	// key times and values, whichever way they are stored
+	const std::vector<float>& GetPositionTimes() const { return m_Times[m_PositionTimes]; }
+	const std::vector<float>& GetRotationTimes() const { return m_Times[m_RotationTimes]; }
+	const std::vector<float>& GetScaleTimes() const { return m_Times[m_ScaleTimes]; }
+	glm::vec3 PositionKey(int index) const
+	{
+		return m_Packed ? UnpackVec3(&m_PackedPositions[3 * index], m_PositionMin, m_PositionExtent) : m_Positions[index];
+	}
+	glm::quat RotationKey(int index) const
+	{
+		return m_Packed ? UnpackQuat(&m_PackedRotations[3 * index]) : m_Rotations[index];
+	}
+	glm::vec3 ScaleKey(int index) const
+	{
+		return m_Packed ? UnpackVec3(&m_PackedScales[3 * index], m_ScaleMin, m_ScaleExtent) : m_Scales[index];
+	}
+
+	// whether the keys are held quantized (see AnimationCompiler)
+	bool IsPacked() const { return m_Packed; }
+
+	// quantizes v within [min, min + extent] to three 16-bit values
+	static void PackVec3(const glm::vec3& v, const glm::vec3& min, const glm::vec3& extent, uint16_t* packed)
 	{
-		for (int index = 0; index < m_NumRotations - 1; ++index)
+		for (int c = 0; c < 3; c++)
 		{
-			if (animationTime < m_Rotations[index + 1].timeStamp)
-				return index;
+			float t = extent[c] > 0.0f ? (v[c] - min[c]) / extent[c] : 0.0f;
+			packed[c] = static_cast<uint16_t>(std::lround(glm::clamp(t, 0.0f, 1.0f) * 65535.0f));
 		}
-		assert(0);
 	}
 
-	int GetScaleIndex(float animationTime)
+	static glm::vec3 UnpackVec3(const uint16_t* packed, const glm::vec3& min, const glm::vec3& extent)
 	{
-		for (int index = 0; index < m_NumScalings - 1; ++index)
+		return min + glm::vec3(packed[0], packed[1], packed[2]) * (extent * (1.0f / 65535.0f));
+	}
+
+	// smallest three: the largest component is dropped (made positive first, q and -q being the same
+	// rotation) and rebuilt from the unit length. The other three lie in [-1/sqrt(2), 1/sqrt(2)] and
+	// keep 15 bits each; the top bits of the first two words hold the index of the dropped one.
+	static void PackQuat(glm::quat q, uint16_t* packed)
+	{
+		q = glm::normalize(q);
+		float c[4] = { q.x, q.y, q.z, q.w };
+		int largest = 0;
+		for (int i = 1; i < 4; i++)
+			if (std::fabs(c[i]) > std::fabs(c[largest]))
+				largest = i;
+		float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+		for (int i = 0, n = 0; i < 4; i++)
 		{
-			if (animationTime < m_Scales[index + 1].timeStamp)
-				return index;
+			if (i == largest)
+				continue;
+			float t = glm::clamp(c[i] * sign * 0.70710678f + 0.5f, 0.0f, 1.0f); // [-1/sqrt(2), 1/sqrt(2)] to [0, 1]
+			packed[n++] = static_cast<uint16_t>(std::lround(t * 32767.0f));
 		}
-		assert(0);
+		packed[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+		packed[1] |= static_cast<uint16_t>((largest & 1) << 15);
 	}
 
+	static glm::quat UnpackQuat(const uint16_t* packed)
+	{
+		int largest = ((packed[0] >> 15) << 1) | (packed[1] >> 15);
+		float c[4];
+		float sum = 0.0f;
+		for (int i = 0, n = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+			c[i] = ((packed[n++] & 0x7fff) * (1.0f / 32767.0f) - 0.5f) * 1.41421356f;
+			sum += c[i] * c[i];
+		}
+		c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+		return glm::quat(c[3], c[0], c[1], c[2]);
+	}
 
-private:
+	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
+	const std::string& GetBoneName() const { return m_Name; }
+	int GetBoneID() { return m_ID; }
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+	// index of the key that starts the interval containing animationTime; times before the first
+	// key give 0 and times at or past the last key give the last interval
+	int GetPositionIndex(float animationTime)
 	{
-		float scaleFactor = 0.0f;
-		float midWayLength = animationTime - lastTimeStamp;
-		float framesDiff = nextTimeStamp - lastTimeStamp;
-		scaleFactor = midWayLength / framesDiff;
-		return scaleFactor;
+		return FindKey(m_Times[m_PositionTimes], animationTime, m_Cursor.position);
 	}
 
-	glm::mat4 InterpolatePosition(float animationTime)
+	int GetRotationIndex(float animationTime)
 	{
-		if (1 == m_NumPositions)
-			return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+		return FindKey(m_Times[m_RotationTimes], animationTime, m_Cursor.rotation);
+	}
 
-		int p0Index = GetPositionIndex(animationTime);
-		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp,
-			m_Positions[p1Index].timeStamp, animationTime);
-		glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
-			, scaleFactor);
-		return glm::translate(glm::mat4(1.0f), finalPosition);
+	int GetScaleIndex(float animationTime)
+	{
+		return FindKey(m_Times[m_ScaleTimes], animationTime, m_Cursor.scale);
 	}
 
-	glm::mat4 InterpolateRotation(float animationTime)
+private:
+
+	// keys reachable by stepping forward from the cursor before switching to a binary search
+	static const int CURSOR_STEPS = 4;
+
+	static int FindKey(const std::vector<float>& times, float animationTime, int& cursor)
 	{
-		if (1 == m_NumRotations)
+		int last = static_cast<int>(times.size()) - 2;
+		if (last <= 0)
+			return cursor = 0;
+
+		int index = std::min(std::max(cursor, 0), last);
+		if (times[index] <= animationTime)
 		{
-			auto rotation = glm::normalize(m_Rotations[0].orientation);
-			return glm::toMat4(rotation);
+			for (int step = 0; step < CURSOR_STEPS && index < last && animationTime >= times[index + 1]; step++)
+				index++;
+			if (index < last && animationTime >= times[index + 1])
+				index = static_cast<int>(std::upper_bound(times.begin() + index + 1, times.end(), animationTime) - times.begin()) - 1;
 		}
+		else
+			index = static_cast<int>(std::upper_bound(times.begin(), times.begin() + index, animationTime) - times.begin()) - 1;
 
-		int p0Index = GetRotationIndex(animationTime);
-		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp,
-			m_Rotations[p1Index].timeStamp, animationTime);
-		glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation
-			, scaleFactor);
-		finalRotation = glm::normalize(finalRotation);
-		return glm::toMat4(finalRotation);
-
+		return cursor = std::min(std::max(index, 0), last);
 	}
 
-	glm::mat4 InterpolateScaling(float animationTime)
+	// the position, rotation and scale keys of most channels are sampled at the same times, so
+	// identical time arrays are stored once
+	int AddTimes(const std::vector<float>& times)
 	{
-		if (1 == m_NumScalings)
-			return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
+		for (size_t i = 0; i < m_Times.size(); i++)
+			if (m_Times[i] == times)
+				return static_cast<int>(i);
+		m_Times.push_back(times);
+		return static_cast<int>(m_Times.size()) - 1;
+	}
 
-		int p0Index = GetScaleIndex(animationTime);
-		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Scales[p0Index].timeStamp,
-			m_Scales[p1Index].timeStamp, animationTime);
-		glm::vec3 finalScale = glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
-			, scaleFactor);
-		return glm::scale(glm::mat4(1.0f), finalScale);
+	static float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+	{
+		float framesDiff = nextTimeStamp - lastTimeStamp;
+		if (framesDiff <= 0.0f)
+			return 0.0f;
+		float midWayLength = animationTime - lastTimeStamp;
+		return glm::clamp(midWayLength / framesDiff, 0.0f, 1.0f);
 	}
 
-	std::vector<KeyPosition> m_Positions;
-	std::vector<KeyRotation> m_Rotations;
-	std::vector<KeyScale> m_Scales;
-	int m_NumPositions;
-	int m_NumRotations;
-	int m_NumScalings;
+	friend class AnimationCompiler;
+
+	// empty track arrays, filled by AnimationCompiler::Load
+	Bone(const std::string& name, int ID) : m_LocalTransform(1.0f), m_Name(name), m_ID(ID) {}
+
+	std::vector<std::vector<float>> m_Times;
+	// full precision keys, or, when m_Packed, 16-bit keys with the ranges they were quantized in
+	std::vector<glm::vec3> m_Positions;
+	std::vector<glm::quat> m_Rotations;
+	std::vector<glm::vec3> m_Scales;
+	bool m_Packed = false;
+	std::vector<uint16_t> m_PackedPositions;
+	std::vector<uint16_t> m_PackedRotations;
+	std::vector<uint16_t> m_PackedScales;
+	glm::vec3 m_PositionMin, m_PositionExtent, m_ScaleMin, m_ScaleExtent;
+	int m_PositionTimes;
+	int m_RotationTimes;
+	int m_ScaleTimes;
+	KeyCursor m_Cursor;
 
 	glm::mat4 m_LocalTransform;
 	std::string m_Name;
@@ -0,0 +1,185 @@
+#ifndef CROWD_ANIMATOR_H
+#define CROWD_ANIMATOR_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/animator.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Animates many characters at once. Every character is an Animator; Update advances all of them on
+// ThreadPool::Shared() and writes their bone palettes straight into one shader storage buffer, so
+// drawing a character only needs its palette offset. On the shader side (see
+// resources/shaders/crowd_skinning.vs):
+//
+//     layout(std430, binding = 0) buffer BonePalettes { mat4 bones[]; };
+//     uniform int paletteOffset; // CrowdAnimator::PaletteOffset(character)
+//     ... bones[paletteOffset + boneIds[i]] ...
+//
+// Shader storage buffers need GL 4.3; on older contexts the constructor logs an error and the
+// characters are still animated but no palettes are written (see Supported). With GL 4.4 the buffer
+// is persistently mapped and split into FRAMES regions written round robin, each guarded by a fence,
+// so the CPU never waits on the GPU reading the previous frames' palettes. A 4.3 context falls back
+// to a single region filled with glBufferSubData.
+class CrowdAnimator
+{
+public:
+    static const unsigned int MAX_BONES = Animator::MAX_BONES;
+    static const unsigned int FRAMES = 3;
+    // characters evaluated per job; enough to amortize the scheduling, small enough to balance
+    static const unsigned int CHARACTERS_PER_JOB = 8;
+
+    // reserves palette space for up to capacity characters
+    explicit CrowdAnimator(unsigned int capacity) : capacity(capacity)
+    {
+        animators.reserve(capacity);
+        if (!Supported())
+        {
+            std::cout << "ERROR::CROWD_ANIMATOR: bone palettes need shader storage buffers (GL 4.3)" << std::endl;
+            return;
+        }
+        GLint alignment = 256;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        regionSize = capacity * MAX_BONES * sizeof(glm::mat4);
+        regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        if (GLAD_GL_VERSION_4_4)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            // dynamic storage keeps glBufferSubData legal should the mapping fail
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, regionSize * FRAMES, nullptr, flags | GL_DYNAMIC_STORAGE_BIT);
+            mapped = static_cast<unsigned char*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, regionSize * FRAMES, flags));
+        }
+        if (!mapped)
+        {
+            // no persistent mapping: one region, uploaded from a CPU copy every frame
+            if (!GLAD_GL_VERSION_4_4)
+                glBufferData(GL_SHADER_STORAGE_BUFFER, regionSize, nullptr, GL_DYNAMIC_DRAW);
+            staging.resize(static_cast<size_t>(capacity) * MAX_BONES, glm::mat4(1.0f));
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    ~CrowdAnimator()
+    {
+        for (GLsync& fence : fences)
+            if (fence)
+                glDeleteSync(fence);
+        if (mapped)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        if (buffer)
+            glDeleteBuffers(1, &buffer);
+    }
+
+    CrowdAnimator(const CrowdAnimator&) = delete;
+    CrowdAnimator& operator=(const CrowdAnimator&) = delete;
+
+    static bool Supported() { return GLAD_GL_VERSION_4_3 != 0; }
+
+    // adds a character playing animation and returns its index, or -1 when the crowd is full
+    int Add(Animation* animation)
+    {
+        if (animators.size() == capacity)
+        {
+            std::cout << "ERROR::CROWD_ANIMATOR: capacity of " << capacity << " characters reached" << std::endl;
+            return -1;
+        }
+        animators.emplace_back(animation);
+        return static_cast<int>(animators.size()) - 1;
+    }
+
+    Animator& Get(int character) { return animators[character]; }
+
+    // see AnimationLodSelector; the character's index staggers its key frames against the others
+    void SetLod(int character, const Animator::Lod& lod) { animators[character].SetLod(lod, character); }
+    unsigned int Count() const { return static_cast<unsigned int>(animators.size()); }
+
+    // index of the character's first matrix in the bound palette buffer
+    int PaletteOffset(int character) const { return character * static_cast<int>(MAX_BONES); }
+
+    // advances every character by dt on pool (the calling thread alone if null) and writes the palettes
+    // for this frame. Blocks only if the GPU is still reading the region written FRAMES frames ago.
+    void Update(float dt, ThreadPool* pool = &ThreadPool::Shared())
+    {
+        glm::mat4* palettes = staging.data();
+        if (mapped)
+        {
+            GLsync& fence = fences[region];
+            if (fence)
+            {
+                while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+                    ;
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+            palettes = reinterpret_cast<glm::mat4*>(mapped + region * regionSize);
+        }
+
+        size_t jobs = (animators.size() + CHARACTERS_PER_JOB - 1) / CHARACTERS_PER_JOB;
+        auto update = [&](size_t job) {
+            size_t end = std::min(animators.size(), (job + 1) * CHARACTERS_PER_JOB);
+            for (size_t character = job * CHARACTERS_PER_JOB; character < end; character++)
+            {
+                Animator& animator = animators[character];
+                animator.UpdateAnimation(dt);
+                // an off screen character is not drawn, so its palette need not be current
+                if (!palettes || !animator.GetLod().visible)
+                    continue;
+                const std::vector<glm::mat4>& bones = animator.GetFinalBoneMatrices();
+                std::memcpy(palettes + character * MAX_BONES, bones.data(), std::min<size_t>(bones.size(), MAX_BONES) * sizeof(glm::mat4));
+            }
+        };
+        if (pool)
+            pool->ParallelFor(jobs, update);
+        else
+            for (size_t job = 0; job < jobs; job++)
+                update(job);
+
+        if (!mapped && !staging.empty() && !animators.empty())
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, animators.size() * MAX_BONES * sizeof(glm::mat4), staging.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+    }
+
+    // binds this frame's palettes to a shader storage binding point
+    void Bind(unsigned int binding = 0) const
+    {
+        if (!buffer)
+            return;
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer, mapped ? region * regionSize : 0, regionSize);
+    }
+
+    // call after the frame's draws that read the palettes have been issued
+    void EndFrame()
+    {
+        if (!mapped)
+            return;
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % FRAMES;
+    }
+
+private:
+    unsigned int capacity;
+    std::vector<Animator> animators;
+    unsigned int buffer = 0;
+    size_t regionSize = 0;
+    unsigned char* mapped = nullptr;
+    unsigned int region = 0;
+    GLsync fences[FRAMES] = {};
+    std::vector<glm::mat4> staging;
+};
+#endif
@@ -5,6 +5,7 @@
 #include <list> //std::list
 #include <array> //std::array
 #include <memory> //std::unique_ptr
+#include <learnopengl/frustum.h> //Plan, Frustum
 
 class Transform
 {
@@ -35,14 +36,17 @@ protected:
 	}
 public:
 
+	//Both clear the dirty flag: the matrix is up to date with the local space again
 	void computeModelMatrix()
 	{
 		m_modelMatrix = getLocalModelMatrix();
+		m_isDirty = false;
 	}
 
 	void computeModelMatrix(const glm::mat4& parentGlobalModelMatrix)
 	{
 		m_modelMatrix = parentGlobalModelMatrix * getLocalModelMatrix();
+		m_isDirty = false;
 	}
 
 	void setLocalPosition(const glm::vec3& newPosition)
@@ -120,36 +124,6 @@ public:
 	}
 };
 
-struct Plan
-{
-	glm::vec3 normal = { 0.f, 1.f, 0.f }; // unit vector
-	float     distance = 0.f;        // Distance with origin
-
-	Plan() = default;
-
-	Plan(const glm::vec3& p1, const glm::vec3& norm)
-		: normal(glm::normalize(norm)),
-		distance(glm::dot(normal, p1))
-	{}
-
-	float getSignedDistanceToPlan(const glm::vec3& point) const
-	{
-		return glm::dot(normal, point) - distance;
-	}
-};
-
-struct Frustum
-{
-	Plan topFace;
-	Plan bottomFace;
-
-	Plan rightFace;
-	Plan leftFace;
-
-	Plan farFace;
-	Plan nearFace;
-};
-
 struct BoundingVolume
 {
 	virtual bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const = 0;
@@ -324,64 +298,18 @@ struct AABB : public BoundingVolume
 	};
 };
 
-Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, float zNear, float zFar)
-{
-	Frustum     frustum;
-	const float halfVSide = zFar * tanf(fovY * .5f);
-	const float halfHSide = halfVSide * aspect;
-	const glm::vec3 frontMultFar = zFar * cam.Front;
-
-	frustum.nearFace = { cam.Position + zNear * cam.Front, cam.Front };
-	frustum.farFace = { cam.Position + frontMultFar, -cam.Front };
-	frustum.rightFace = { cam.Position, glm::cross(cam.Up, frontMultFar + cam.Right * halfHSide) };
-	frustum.leftFace = { cam.Position, glm::cross(frontMultFar - cam.Right * halfHSide, cam.Up) };
-	frustum.topFace = { cam.Position, glm::cross(cam.Right, frontMultFar - cam.Up * halfVSide) };
-	frustum.bottomFace = { cam.Position, glm::cross(frontMultFar + cam.Up * halfVSide, cam.Right) };
-
-	return frustum;
-}
-
+// both use the bounds the model computed at load time, so they work after its meshes released their vertices
 AABB generateAABB(const Model& model)
 {
-	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
-	for (auto&& mesh : model.meshes)
-	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
-	}
-	return AABB(minAABB, maxAABB);
+	return AABB(model.boundsMin, model.boundsMax);
 }
 
 Sphere generateSphereBV(const Model& model)
 {
-	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
-	for (auto&& mesh : model.meshes)
-	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
-	}
-
-	return Sphere((maxAABB + minAABB) * 0.5f, glm::length(minAABB - maxAABB));
+	return Sphere((model.boundsMax + model.boundsMin) * 0.5f, glm::length(model.boundsMin - model.boundsMax));
 }
 
+// One heap node per entity, walked recursively; for scenes with many nodes see SceneGraph (scene_graph.h)
 class Entity
 {
 public:
@@ -436,27 +364,36 @@ public:
 		children.back()->parent = this;
 	}
 
-	//Update transform if it was changed
-	void updateSelfAndChild()
+	//Update transform if it or one of its parents was changed, and return how many transforms were recomputed
+	unsigned int updateSelfAndChild(bool parentChanged = false)
 	{
-		if (!transform.isDirty())
-			return;
+		const bool changed = parentChanged || transform.isDirty();
+		unsigned int recomputed = 0;
+		if (changed)
+		{
+			computeModelMatrix();
+			recomputed++;
+		}
 
-		forceUpdateSelfAndChild();
+		//A child can be dirty on its own, so the walk goes on even below unchanged entities
+		for (auto&& child : children)
+		{
+			recomputed += child->updateSelfAndChild(changed);
+		}
+		return recomputed;
 	}
 
 	//Force update of transform even if local space don't change
-	void forceUpdateSelfAndChild()
+	unsigned int forceUpdateSelfAndChild()
 	{
-		if (parent)
-			transform.computeModelMatrix(parent->transform.getModelMatrix());
-		else
-			transform.computeModelMatrix();
+		computeModelMatrix();
 
+		unsigned int recomputed = 1;
 		for (auto&& child : children)
 		{
-			child->forceUpdateSelfAndChild();
+			recomputed += child->forceUpdateSelfAndChild();
 		}
+		return recomputed;
 	}
 
 
@@ -475,5 +412,14 @@ public:
 			child->drawSelfAndChild(frustum, ourShader, display, total);
 		}
 	}
+
+private:
+	void computeModelMatrix()
+	{
+		if (parent)
+			transform.computeModelMatrix(parent->transform.getModelMatrix());
+		else
+			transform.computeModelMatrix();
+	}
 };
 #endif
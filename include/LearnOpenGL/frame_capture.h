@@ -0,0 +1,220 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+
+// Offscreen render target with asynchronous readback. Render into Framebuffer(), then Capture()
+// queues a glReadPixels into one of a ring of pixel pack buffers and returns immediately; the
+// pixels are mapped and written out only when that buffer comes around again (or on Flush()), by
+// which time the GPU has long finished the copy, so capturing every frame does not stall the pipeline.
+//
+// Files ending in ".png" are written as PNG, anything else as raw top-down RGBA8 rows.
+class FrameCapture
+{
+public:
+    unsigned int Width = 0, Height = 0;
+
+    ~FrameCapture() { Release(); }
+
+    // creates an RGBA8 + depth/stencil framebuffer and `buffers` pixel pack buffers for in-flight readbacks
+    bool Init(unsigned int width, unsigned int height, unsigned int buffers = 3)
+    {
+        Width = width;
+        Height = height;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(2, renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete)
+        {
+            std::cout << "ERROR::FRAME_CAPTURE: framebuffer is not complete" << std::endl;
+            return false;
+        }
+
+        slots.resize(buffers > 0 ? buffers : 1);
+        for (Slot& slot : slots)
+        {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return true;
+    }
+
+    unsigned int Framebuffer() const { return fbo; }
+
+    // queues a readback of the current framebuffer contents, to be written to path
+    void Capture(const std::string& path)
+    {
+        Slot& slot = slots[next];
+        retire(slot);
+        next = (next + 1) % slots.size();
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, Width, Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.path = path;
+    }
+
+    // writes out every readback still in flight, oldest first
+    void Flush()
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+            retire(slots[(next + i) % slots.size()]);
+    }
+
+    void Release()
+    {
+        if (fbo == 0)
+            return;
+        Flush();
+        for (Slot& slot : slots)
+            glDeleteBuffers(1, &slot.pbo);
+        slots.clear();
+        glDeleteRenderbuffers(2, renderbuffers);
+        glDeleteFramebuffers(1, &fbo);
+        fbo = 0;
+    }
+
+    // writes bottom-up RGBA8 pixels (as returned by glReadPixels) as a top-down image file
+    static bool Write(const std::string& path, unsigned int width, unsigned int height, const unsigned char* pixels)
+    {
+        std::vector<unsigned char> data;
+        const bool png = path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+        const size_t stride = (size_t)width * 4;
+        data.reserve((stride + (png ? 1 : 0)) * height);
+        for (unsigned int y = 0; y < height; ++y)
+        {
+            if (png)
+                data.push_back(0); // filter type: none
+            const unsigned char* row = pixels + (height - 1 - y) * stride;
+            data.insert(data.end(), row, row + stride);
+        }
+        if (png)
+            data = encodePNG(width, height, data);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!file)
+        {
+            std::cout << "ERROR::FRAME_CAPTURE: failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        unsigned int pbo = 0;
+        GLsync fence = nullptr;
+        std::string path;
+    };
+
+    unsigned int fbo = 0;
+    unsigned int renderbuffers[2] = { 0, 0 };
+    std::vector<Slot> slots;
+    size_t next = 0;
+
+    void retire(Slot& slot)
+    {
+        if (slot.fence == nullptr)
+            return;
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)Width * Height * 4, GL_MAP_READ_BIT);
+        if (pixels != nullptr)
+        {
+            Write(slot.path, Width, Height, static_cast<const unsigned char*>(pixels));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // minimal PNG encoder: 8-bit RGBA, filtered scanlines stored in uncompressed deflate blocks
+    static std::vector<unsigned char> encodePNG(unsigned int width, unsigned int height, const std::vector<unsigned char>& scanlines)
+    {
+        std::vector<unsigned char> zlib = { 0x78, 0x01 };
+        uint32_t a = 1, b = 0; // adler-32
+        size_t offset = 0;
+        bool last;
+        do
+        {
+            size_t length = std::min<size_t>(scanlines.size() - offset, 65535);
+            last = offset + length == scanlines.size();
+            zlib.push_back(last ? 1 : 0);
+            zlib.push_back(length & 0xff);
+            zlib.push_back(length >> 8);
+            zlib.push_back(~length & 0xff);
+            zlib.push_back((~length >> 8) & 0xff);
+            for (size_t i = offset; i < offset + length; ++i)
+            {
+                a = (a + scanlines[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+            zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + length);
+            offset += length;
+        } while (!last);
+        putBigEndian(zlib, (b << 16) | a);
+
+        std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        std::vector<unsigned char> header;
+        putBigEndian(header, width);
+        putBigEndian(header, height);
+        header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit, RGBA, deflate, no filter method, no interlace
+        putChunk(png, "IHDR", header);
+        putChunk(png, "IDAT", zlib);
+        putChunk(png, "IEND", {});
+        return png;
+    }
+
+    static void putBigEndian(std::vector<unsigned char>& out, uint32_t value)
+    {
+        out.insert(out.end(), { (unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value });
+    }
+
+    static void putChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data)
+    {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        putBigEndian(out, (uint32_t)data.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        uint32_t crc = 0xffffffffu;
+        for (size_t i = start; i < out.size(); ++i)
+            crc = table[(crc ^ out[i]) & 0xff] ^ (crc >> 8);
+        putBigEndian(out, crc ^ 0xffffffffu);
+    }
+};
+#endif
@@ -0,0 +1,65 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <learnopengl/camera.h>
+
+struct Plan
+{
+	glm::vec3 normal = { 0.f, 1.f, 0.f }; // unit vector
+	float     distance = 0.f;        // Distance with origin
+
+	Plan() = default;
+
+	Plan(const glm::vec3& p1, const glm::vec3& norm)
+		: normal(glm::normalize(norm)),
+		distance(glm::dot(normal, p1))
+	{}
+
+	float getSignedDistanceToPlan(const glm::vec3& point) const
+	{
+		return glm::dot(normal, point) - distance;
+	}
+};
+
+struct Frustum
+{
+	Plan topFace;
+	Plan bottomFace;
+
+	Plan rightFace;
+	Plan leftFace;
+
+	Plan farFace;
+	Plan nearFace;
+};
+
+inline Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, float zNear, float zFar)
+{
+	Frustum     frustum;
+	const float halfVSide = zFar * tanf(fovY * .5f);
+	const float halfHSide = halfVSide * aspect;
+	const glm::vec3 frontMultFar = zFar * cam.Front;
+
+	frustum.nearFace = { cam.Position + zNear * cam.Front, cam.Front };
+	frustum.farFace = { cam.Position + frontMultFar, -cam.Front };
+	frustum.rightFace = { cam.Position, glm::cross(cam.Up, frontMultFar + cam.Right * halfHSide) };
+	frustum.leftFace = { cam.Position, glm::cross(frontMultFar - cam.Right * halfHSide, cam.Up) };
+	frustum.topFace = { cam.Position, glm::cross(cam.Right, frontMultFar - cam.Up * halfVSide) };
+	frustum.bottomFace = { cam.Position, glm::cross(frontMultFar + cam.Up * halfVSide, cam.Right) };
+
+	return frustum;
+}
+
+// true when a sphere is at least partly inside the frustum
+inline bool isSphereOnFrustum(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+	return (frustum.leftFace.getSignedDistanceToPlan(center) > -radius &&
+		frustum.rightFace.getSignedDistanceToPlan(center) > -radius &&
+		frustum.farFace.getSignedDistanceToPlan(center) > -radius &&
+		frustum.nearFace.getSignedDistanceToPlan(center) > -radius &&
+		frustum.topFace.getSignedDistanceToPlan(center) > -radius &&
+		frustum.bottomFace.getSignedDistanceToPlan(center) > -radius);
+}
+#endif
@@ -0,0 +1,121 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// AVX when the compiler targets it (-mavx), else SSE, which every x86-64 CPU has
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LOGL_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOGL_CULL_SSE
+#endif
+
+// Tests many axis aligned boxes against a frustum at once. The boxes are given as one array per
+// component of their centers and extents (see SceneGraph), so 8 (AVX) or 4 (SSE) boxes are loaded
+// into registers and checked against all six planes without branches; a box is kept when it is not
+// entirely behind any plane, as in AABB::isOnOrForwardPlan. The result is a compact list of the
+// indices of the boxes kept, in increasing order.
+class FrustumCuller
+{
+public:
+    explicit FrustumCuller(const Frustum& frustum)
+    {
+        const Plan* faces[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace,
+                                 &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec3& n = faces[p]->normal;
+            planes[p] = { { n.x, n.y, n.z, std::abs(n.x), std::abs(n.y), std::abs(n.z), faces[p]->distance } };
+        }
+    }
+
+    // replaces visible with the indices of the boxes touching the frustum and returns their count
+    size_t Cull(const float* centerX, const float* centerY, const float* centerZ,
+                const float* extentX, const float* extentY, const float* extentZ,
+                size_t count, std::vector<unsigned int>& visible) const
+    {
+        // reserve rather than resize: most boxes are usually culled, and resizing would zero them all
+        visible.clear();
+        visible.reserve(count);
+        size_t i = 0;
+#if defined(LOGL_CULL_AVX)
+        // plane components broadcast once, outside the loop
+        __m256 p[6][7];
+        for (int k = 0; k < 6; k++)
+            for (int c = 0; c < 7; c++)
+                p[k][c] = _mm256_set1_ps(planes[k].values[c]);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(centerX + i), cy = _mm256_loadu_ps(centerY + i), cz = _mm256_loadu_ps(centerZ + i);
+            __m256 ex = _mm256_loadu_ps(extentX + i), ey = _mm256_loadu_ps(extentY + i), ez = _mm256_loadu_ps(extentZ + i);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int k = 0; k < 6; k++)
+            {
+                // signed distance of the center plus the box's projected radius
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, p[k][0]), _mm256_mul_ps(cy, p[k][1])), _mm256_mul_ps(cz, p[k][2]));
+                __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, p[k][3]), _mm256_mul_ps(ey, p[k][4])), _mm256_mul_ps(ez, p[k][5]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), p[k][6], _CMP_GE_OQ));
+            }
+            append(visible, static_cast<unsigned int>(_mm256_movemask_ps(inside)), i);
+        }
+#elif defined(LOGL_CULL_SSE)
+        // plane components broadcast once, outside the loop
+        __m128 p[6][7];
+        for (int k = 0; k < 6; k++)
+            for (int c = 0; c < 7; c++)
+                p[k][c] = _mm_set1_ps(planes[k].values[c]);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(centerX + i), cy = _mm_loadu_ps(centerY + i), cz = _mm_loadu_ps(centerZ + i);
+            __m128 ex = _mm_loadu_ps(extentX + i), ey = _mm_loadu_ps(extentY + i), ez = _mm_loadu_ps(extentZ + i);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int k = 0; k < 6; k++)
+            {
+                // signed distance of the center plus the box's projected radius
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, p[k][0]), _mm_mul_ps(cy, p[k][1])), _mm_mul_ps(cz, p[k][2]));
+                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, p[k][3]), _mm_mul_ps(ey, p[k][4])), _mm_mul_ps(ez, p[k][5]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), p[k][6]));
+            }
+            append(visible, static_cast<unsigned int>(_mm_movemask_ps(inside)), i);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            bool inside = true;
+            for (const Plane& plane : planes)
+            {
+                const float* v = plane.values;
+                inside &= v[0] * centerX[i] + v[1] * centerY[i] + v[2] * centerZ[i] +
+                          v[3] * extentX[i] + v[4] * extentY[i] + v[5] * extentZ[i] >= v[6];
+            }
+            if (inside)
+                visible.push_back(static_cast<unsigned int>(i));
+        }
+        return visible.size();
+    }
+
+private:
+    // the normal, its absolute value (to project the extents) and the plane's distance to the origin
+    struct Plane
+    {
+        float values[7];
+    };
+    Plane planes[6];
+
+    // writes first + the position of each set bit of mask
+    static void append(std::vector<unsigned int>& visible, unsigned int mask, size_t first)
+    {
+        for (unsigned int bit = 0; mask; bit++, mask >>= 1)
+            if (mask & 1u)
+                visible.push_back(static_cast<unsigned int>(first) + bit);
+    }
+};
+#endif
@@ -0,0 +1,339 @@
+#ifndef GL_COUNTER_H
+#define GL_COUNTER_H
+
+#include <glad/glad.h>
+
+#include <map>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Debug instrumentation for the glad function table. Install() swaps a handful of glad's function
+// pointers for wrappers that count draw calls, state changes, buffer upload bytes and texture binds
+// before forwarding to the driver. Counts are attributed to the innermost GLCounter::Scope (e.g.
+// "SpriteRenderer", "ImGui") and written as one JSON object per frame by EndFrame().
+//
+// NullLoader can be handed to gladLoadGLLoader instead of a real context's loader: it resolves every
+// entry point to a stub that does nothing, so the renderer runs (and is counted) on machines without
+// a GPU or display. The generic stub ignores its arguments, which is only sound on ABIs where the caller
+// cleans up the stack (x86-64, ARM64), not with 32-bit __stdcall.
+class GLCounter
+{
+public:
+    struct Stats
+    {
+        unsigned long long drawCalls = 0;
+        unsigned long long stateChanges = 0;
+        unsigned long long bufferUploadBytes = 0;
+        unsigned long long textureBinds = 0;
+    };
+
+    // attributes every GL call made during its lifetime to the given subsystem
+    class Scope
+    {
+    public:
+        Scope(const char* subsystem) : previous(current) { current = subsystem; }
+        ~Scope() { current = previous; }
+    private:
+        const char* previous;
+    };
+
+    // wraps glad's function pointers; call once after gladLoadGL(Loader)
+    static void Install()
+    {
+        if (installed)
+            return;
+        installed = true;
+        hook(glad_glDrawArrays, real.DrawArrays, drawArrays);
+        hook(glad_glDrawElements, real.DrawElements, drawElements);
+        hook(glad_glDrawArraysInstanced, real.DrawArraysInstanced, drawArraysInstanced);
+        hook(glad_glDrawElementsInstanced, real.DrawElementsInstanced, drawElementsInstanced);
+        hook(glad_glDrawElementsBaseVertex, real.DrawElementsBaseVertex, drawElementsBaseVertex);
+        hook(glad_glMultiDrawElementsIndirect, real.MultiDrawElementsIndirect, multiDrawElementsIndirect);
+        hook(glad_glUseProgram, real.UseProgram, useProgram);
+        hook(glad_glBindVertexArray, real.BindVertexArray, bindVertexArray);
+        hook(glad_glBindFramebuffer, real.BindFramebuffer, bindFramebuffer);
+        hook(glad_glBindBuffer, real.BindBuffer, bindBuffer);
+        hook(glad_glActiveTexture, real.ActiveTexture, activeTexture);
+        hook(glad_glEnable, real.Enable, enable);
+        hook(glad_glDisable, real.Disable, disable);
+        hook(glad_glBlendFunc, real.BlendFunc, blendFunc);
+        hook(glad_glViewport, real.Viewport, viewport);
+        hook(glad_glBufferData, real.BufferData, bufferData);
+        hook(glad_glBufferSubData, real.BufferSubData, bufferSubData);
+        hook(glad_glBindTexture, real.BindTexture, bindTexture);
+    }
+
+    // adds counts for work issued outside the glad table (e.g. a library with its own GL loader)
+    static void Add(const char* subsystem, const Stats& stats)
+    {
+        accumulate(frame[subsystem], stats);
+    }
+
+    // per-frame output; frames are written as a JSON array so the whole file parses in one go
+    static bool Open(const std::string& path)
+    {
+        output = fopen(path.c_str(), "w");
+        if (output == nullptr)
+        {
+            std::cout << "ERROR::GL_COUNTER: cannot open " << path << std::endl;
+            return false;
+        }
+        fputs("[", output);
+        framesWritten = 0;
+        return true;
+    }
+
+    static void Close()
+    {
+        if (output == nullptr)
+            return;
+        fputs("\n]\n", output);
+        fclose(output);
+        output = nullptr;
+    }
+
+    // closes the current frame: writes it out (if a file is open) and resets the counters
+    static void EndFrame()
+    {
+        if (output != nullptr)
+        {
+            Stats total;
+            for (auto& entry : frame)
+                accumulate(total, entry.second);
+            fprintf(output, "%s\n  {\"frame\": %llu, \"total\": ", framesWritten == 0 ? "" : ",", framesWritten);
+            write(total);
+            fputs(", \"subsystems\": {", output);
+            bool first = true;
+            for (auto& entry : frame)
+            {
+                fprintf(output, "%s\"%s\": ", first ? "" : ", ", entry.first.c_str());
+                write(entry.second);
+                first = false;
+            }
+            fputs("}}", output);
+            framesWritten++;
+        }
+        last = frame;
+        frame.clear();
+    }
+
+    // counters of the last finished frame, keyed by subsystem
+    static const std::map<std::string, Stats>& LastFrame() { return last; }
+
+    // loader for gladLoadGLLoader that resolves every entry point to a no-op stub
+    static void* NullLoader(const char* name)
+    {
+        static const std::map<std::string, void*> stubs = {
+            { "glGetString",          (void*)nullGetString },
+            { "glGetStringi",         (void*)nullGetStringi },
+            { "glGetIntegerv",        (void*)nullGetIntegerv },
+            { "glGetShaderiv",        (void*)nullGetStatus },
+            { "glGetProgramiv",       (void*)nullGetStatus },
+            { "glGenBuffers",         (void*)nullGen },
+            { "glGenTextures",        (void*)nullGen },
+            { "glGenVertexArrays",    (void*)nullGen },
+            { "glGenFramebuffers",    (void*)nullGen },
+            { "glGenRenderbuffers",   (void*)nullGen },
+            { "glCreateShader",       (void*)nullCreate },
+            { "glCreateProgram",      (void*)nullCreate },
+            { "glGetUniformLocation", (void*)nullGetLocation },
+            { "glGetAttribLocation",  (void*)nullGetLocation },
+            { "glCheckFramebufferStatus", (void*)nullFramebufferStatus },
+        };
+        auto stub = stubs.find(name);
+        return stub != stubs.end() ? stub->second : (void*)nullNoop;
+    }
+
+private:
+    struct RealFunctions
+    {
+        PFNGLDRAWARRAYSPROC DrawArrays;
+        PFNGLDRAWELEMENTSPROC DrawElements;
+        PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+        PFNGLDRAWELEMENTSINSTANCEDPROC DrawElementsInstanced;
+        PFNGLDRAWELEMENTSBASEVERTEXPROC DrawElementsBaseVertex;
+        PFNGLMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect;
+        PFNGLUSEPROGRAMPROC UseProgram;
+        PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+        PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+        PFNGLBINDBUFFERPROC BindBuffer;
+        PFNGLACTIVETEXTUREPROC ActiveTexture;
+        PFNGLENABLEPROC Enable;
+        PFNGLDISABLEPROC Disable;
+        PFNGLBLENDFUNCPROC BlendFunc;
+        PFNGLVIEWPORTPROC Viewport;
+        PFNGLBUFFERDATAPROC BufferData;
+        PFNGLBUFFERSUBDATAPROC BufferSubData;
+        PFNGLBINDTEXTUREPROC BindTexture;
+    };
+
+    static inline RealFunctions real = {};
+    static inline bool installed = false;
+    static inline const char* current = "Other";
+    static inline std::map<std::string, Stats> frame;
+    static inline std::map<std::string, Stats> last;
+    static inline unsigned long long framesWritten = 0;
+    static inline FILE* output = nullptr;
+
+    template <typename Proc>
+    static void hook(Proc& slot, Proc& saved, Proc wrapper)
+    {
+        saved = slot;
+        if (slot != nullptr) // entry points above the context's version stay unresolved
+            slot = wrapper;
+    }
+
+    static Stats& stats() { return frame[current]; }
+
+    static void accumulate(Stats& to, const Stats& from)
+    {
+        to.drawCalls += from.drawCalls;
+        to.stateChanges += from.stateChanges;
+        to.bufferUploadBytes += from.bufferUploadBytes;
+        to.textureBinds += from.textureBinds;
+    }
+
+    static void write(const Stats& stats)
+    {
+        fprintf(output, "{\"draw_calls\": %llu, \"state_changes\": %llu, \"buffer_upload_bytes\": %llu, \"texture_binds\": %llu}",
+                stats.drawCalls, stats.stateChanges, stats.bufferUploadBytes, stats.textureBinds);
+    }
+
+    // counting wrappers
+    // ------------------------------------------------------------------------
+    static void APIENTRY drawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        stats().drawCalls++;
+        real.DrawArrays(mode, first, count);
+    }
+    static void APIENTRY drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        stats().drawCalls++;
+        real.DrawElements(mode, count, type, indices);
+    }
+    static void APIENTRY drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+    {
+        stats().drawCalls++;
+        real.DrawArraysInstanced(mode, first, count, instances);
+    }
+    static void APIENTRY drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances)
+    {
+        stats().drawCalls++;
+        real.DrawElementsInstanced(mode, count, type, indices, instances);
+    }
+    static void APIENTRY drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex)
+    {
+        stats().drawCalls++;
+        real.DrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    }
+    static void APIENTRY multiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride)
+    {
+        stats().drawCalls++;
+        real.MultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    }
+    static void APIENTRY useProgram(GLuint program)
+    {
+        stats().stateChanges++;
+        real.UseProgram(program);
+    }
+    static void APIENTRY bindVertexArray(GLuint array)
+    {
+        stats().stateChanges++;
+        real.BindVertexArray(array);
+    }
+    static void APIENTRY bindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        stats().stateChanges++;
+        real.BindFramebuffer(target, framebuffer);
+    }
+    static void APIENTRY bindBuffer(GLenum target, GLuint buffer)
+    {
+        stats().stateChanges++;
+        real.BindBuffer(target, buffer);
+    }
+    static void APIENTRY activeTexture(GLenum texture)
+    {
+        stats().stateChanges++;
+        real.ActiveTexture(texture);
+    }
+    static void APIENTRY enable(GLenum cap)
+    {
+        stats().stateChanges++;
+        real.Enable(cap);
+    }
+    static void APIENTRY disable(GLenum cap)
+    {
+        stats().stateChanges++;
+        real.Disable(cap);
+    }
+    static void APIENTRY blendFunc(GLenum sfactor, GLenum dfactor)
+    {
+        stats().stateChanges++;
+        real.BlendFunc(sfactor, dfactor);
+    }
+    static void APIENTRY viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        stats().stateChanges++;
+        real.Viewport(x, y, width, height);
+    }
+    static void APIENTRY bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+    {
+        if (data != nullptr) // allocation only, nothing is uploaded
+            stats().bufferUploadBytes += size;
+        real.BufferData(target, size, data, usage);
+    }
+    static void APIENTRY bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        stats().bufferUploadBytes += size;
+        real.BufferSubData(target, offset, size, data);
+    }
+    static void APIENTRY bindTexture(GLenum target, GLuint texture)
+    {
+        stats().textureBinds++;
+        real.BindTexture(target, texture);
+    }
+
+    // null GL stubs
+    // ------------------------------------------------------------------------
+    static inline GLuint nextName = 1;
+
+    static GLuint64 APIENTRY nullNoop() { return 0; }
+    static const GLubyte* APIENTRY nullGetString(GLenum name)
+    {
+        switch (name)
+        {
+        case GL_VERSION:  return reinterpret_cast<const GLubyte*>("4.6 (Core Profile) NullGL");
+        case GL_VENDOR:   return reinterpret_cast<const GLubyte*>("LearnOpenGL");
+        case GL_RENDERER: return reinterpret_cast<const GLubyte*>("NullGL");
+        default:          return reinterpret_cast<const GLubyte*>("");
+        }
+    }
+    static const GLubyte* APIENTRY nullGetStringi(GLenum, GLuint) { return reinterpret_cast<const GLubyte*>(""); }
+    static void APIENTRY nullGetIntegerv(GLenum name, GLint* data)
+    {
+        switch (name)
+        {
+        case GL_MAJOR_VERSION:             *data = 4; break;
+        case GL_MINOR_VERSION:             *data = 6; break;
+        case GL_MAX_TEXTURE_SIZE:          *data = 16384; break;
+        case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: *data = 32; break;
+        default:                           *data = 0; break;
+        }
+    }
+    // compile/link status queries succeed, log lengths are empty
+    static void APIENTRY nullGetStatus(GLuint, GLenum name, GLint* data)
+    {
+        *data = (name == GL_COMPILE_STATUS || name == GL_LINK_STATUS) ? GL_TRUE : 0;
+    }
+    static void APIENTRY nullGen(GLsizei count, GLuint* names)
+    {
+        for (GLsizei i = 0; i < count; ++i)
+            names[i] = nextName++;
+    }
+    static GLuint APIENTRY nullCreate() { return nextName++; }
+    static GLint APIENTRY nullGetLocation(GLuint, const GLchar*) { return 0; }
+    static GLenum APIENTRY nullFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+};
+#endif
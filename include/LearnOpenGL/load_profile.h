@@ -0,0 +1,75 @@
+#ifndef LOAD_PROFILE_H
+#define LOAD_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Wall time spent in each stage of loading a model. The loader times its stages with
+// LoadProfile::Timer, which costs nothing unless a profile is installed with Install (see the
+// model import benchmark). Stages that run on worker threads add up their threads' time.
+class LoadProfile
+{
+public:
+    enum Stage {
+        CACHE_OPEN,     // looking up and mapping the compiled model
+        READ_FILE,      // Assimp::Importer::ReadFile, including its post-processing
+        PROCESS_NODES,  // walking the node hierarchy
+        PROCESS_MESHES, // vertex/index extraction, optimization and LOD generation
+        TEXTURE_DECODE, // stb_image decoding (and mip generation when streaming)
+        TEXTURE_UPLOAD, // glTexImage2D and mipmap generation
+        MESH_UPLOAD,    // vertex packing and buffer uploads
+        CACHE_STORE,    // writing the compiled model
+        STAGES
+    };
+
+    static const char* Name(Stage stage)
+    {
+        static const char* names[STAGES] = { "cache_open", "read_file", "process_nodes", "process_meshes",
+                                             "texture_decode", "texture_upload", "mesh_upload", "cache_store" };
+        return names[stage];
+    }
+
+    double Seconds(Stage stage) const { return nanoseconds[stage].load() * 1e-9; }
+
+    void Reset()
+    {
+        for (std::atomic<int64_t>& stage : nanoseconds)
+            stage = 0;
+    }
+
+    // makes profile receive all timings from now on; nullptr stops profiling
+    static void Install(LoadProfile* profile) { active().store(profile); }
+
+    class Timer
+    {
+    public:
+        explicit Timer(Stage stage) : stage(stage), profile(active().load())
+        {
+            if (profile)
+                start = std::chrono::steady_clock::now();
+        }
+        ~Timer()
+        {
+            if (profile)
+                profile->nanoseconds[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        Stage stage;
+        LoadProfile* profile;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    std::atomic<int64_t> nanoseconds[STAGES] = {};
+
+    static std::atomic<LoadProfile*>& active()
+    {
+        static std::atomic<LoadProfile*> profile{ nullptr };
+        return profile;
+    }
+};
+#endif
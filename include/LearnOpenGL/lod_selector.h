@@ -0,0 +1,71 @@
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Picks a level of detail from the projected size of its simplification error: the coarsest
+// level whose error covers at most `pixelError` pixels on screen at the instance's distance.
+class LodSelector
+{
+public:
+    LodSelector(float fovY, float viewportHeight, float pixelError = 1.0f)
+        : pixelsPerUnit(viewportHeight / (2.0f * std::tan(fovY * 0.5f))), pixelError(pixelError)
+    {
+    }
+
+    // levelErrors[i] is the error of level i in model units (see Model::LodErrors), scale the instance's
+    // largest axis scale and distance its distance to the camera
+    unsigned int Select(const std::vector<float>& levelErrors, float scale, float distance) const
+    {
+        float pixelsPerModelUnit = scale * pixelsPerUnit / std::max(distance, 1e-4f);
+        for (size_t level = levelErrors.size(); level-- > 1; )
+            if (levelErrors[level] * pixelsPerModelUnit <= pixelError)
+                return static_cast<unsigned int>(level);
+        return 0;
+    }
+
+private:
+    float pixelsPerUnit; // screen pixels covered by one unit at distance 1
+    float pixelError;
+};
+
+// Sorts instance matrices by level of detail, so each level is drawn as one instanced call over a
+// contiguous range of the instance buffer.
+class InstanceLodBuckets
+{
+public:
+    std::vector<glm::mat4> Sorted;   // instance matrices grouped by level
+    std::vector<unsigned int> First; // first instance of each level in Sorted
+    std::vector<unsigned int> Count; // instances per level
+
+    void Build(const glm::mat4* matrices, size_t count, glm::vec3 cameraPosition, const LodSelector& selector, const std::vector<float>& levelErrors)
+    {
+        size_t levels = std::max<size_t>(levelErrors.size(), 1);
+        First.assign(levels, 0);
+        Count.assign(levels, 0);
+        level.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::mat4& m = matrices[i];
+            float scale = std::sqrt(std::max(glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+                                    std::max(glm::dot(glm::vec3(m[1]), glm::vec3(m[1])), glm::dot(glm::vec3(m[2]), glm::vec3(m[2])))));
+            level[i] = selector.Select(levelErrors, scale, glm::length(glm::vec3(m[3]) - cameraPosition));
+            Count[level[i]]++;
+        }
+        // counting sort
+        for (size_t l = 1; l < levels; l++)
+            First[l] = First[l - 1] + Count[l - 1];
+        std::vector<unsigned int> fill = First;
+        Sorted.resize(count);
+        for (size_t i = 0; i < count; i++)
+            Sorted[fill[level[i]]++] = matrices[i];
+    }
+
+private:
+    std::vector<unsigned int> level;
+};
+#endif
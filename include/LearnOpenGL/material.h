@@ -0,0 +1,122 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct Texture {
+    unsigned int id;
+    std::string type;
+    std::string path;
+};
+
+// Every sampler name a model shader may declare gets a fixed texture unit: texture_diffuseN uses
+// unit N-1, texture_specularN 4+N-1, texture_normalN 8+N-1 and texture_heightN 12+N-1. Sampler
+// uniforms are then set once per program instead of being looked up by name on every draw. Programs
+// are passed by ID, so this header does not depend on any Shader class (ShaderWatcher includes it
+// from code that has its own).
+class MaterialBindings
+{
+public:
+    static const unsigned int TYPES = 4;
+    static const unsigned int MAX_PER_TYPE = 4;
+    static const unsigned int UNITS = TYPES * MAX_PER_TYPE;
+
+    static const std::string& TypeName(unsigned int type)
+    {
+        static const std::string names[TYPES] = { "texture_diffuse", "texture_specular", "texture_normal", "texture_height" };
+        return names[type];
+    }
+
+    // index of a texture type name, or -1
+    static int Type(const std::string& name)
+    {
+        for (unsigned int t = 0; t < TYPES; t++)
+            if (name == TypeName(t))
+                return static_cast<int>(t);
+        return -1;
+    }
+
+    // texture unit of the number-th (1-based) texture of a type, or -1 if it has no slot
+    static int Unit(int type, unsigned int number)
+    {
+        if (type < 0 || number == 0 || number > MAX_PER_TYPE)
+            return -1;
+        return static_cast<int>(type * MAX_PER_TYPE + number - 1);
+    }
+
+    // points the program's samplers at their units the first time it is seen; the program must
+    // be in use
+    static void Resolve(unsigned int program)
+    {
+        if (!resolved().insert(program).second)
+            return;
+        for (unsigned int t = 0; t < TYPES; t++)
+            for (unsigned int n = 1; n <= MAX_PER_TYPE; n++)
+            {
+                int location = glGetUniformLocation(program, (TypeName(t) + std::to_string(n)).c_str());
+                if (location != -1)
+                    glUniform1i(location, Unit(static_cast<int>(t), n));
+            }
+    }
+
+    // forgets a program, e.g. before its ID is deleted and possibly reused
+    static void Forget(unsigned int program)
+    {
+        resolved().erase(program);
+    }
+
+private:
+    static std::unordered_set<unsigned int>& resolved()
+    {
+        static std::unordered_set<unsigned int> programs;
+        return programs;
+    }
+};
+
+// The textures of a mesh together with the unit each one binds to, worked out once when the
+// material is created so drawing only binds textures.
+class Material
+{
+public:
+    std::vector<Texture> textures;
+    std::vector<int>     units; // per texture, -1 for types without a slot
+
+    Material() = default;
+    explicit Material(const std::vector<Texture>& textures) : textures(textures)
+    {
+        unsigned int counts[MaterialBindings::TYPES] = {};
+        for (const Texture& texture : textures)
+        {
+            int type = MaterialBindings::Type(texture.type);
+            units.push_back(type < 0 ? -1 : MaterialBindings::Unit(type, ++counts[type]));
+        }
+    }
+
+    // two materials are interchangeable when they bind the same textures to the same units
+    bool SameBindings(const Material& other) const
+    {
+        if (units != other.units)
+            return false;
+        for (size_t i = 0; i < textures.size(); i++)
+            if (textures[i].id != other.textures[i].id)
+                return false;
+        return true;
+    }
+
+    void Bind() const
+    {
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            if (units[i] < 0)
+                continue;
+            glActiveTexture(GL_TEXTURE0 + units[i]);
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+};
+#endif
@@ -5,14 +5,21 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <learnopengl/shader.h>
+#include <learnopengl/material.h>
 
+#include <cmath>
+#include <cstdint>
+#include <iostream>
 #include <string>
 #include <vector>
 using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
+// first of the four locations (one per column) of the per-instance model matrix, see Mesh::DrawInstanced
+#define INSTANCE_MATRIX_ATTRIBUTE 7
 
 struct Vertex {
     // position
@@ -31,67 +38,292 @@ struct Vertex {
 	float m_Weights[MAX_BONE_INFLUENCE];
 };
 
-struct Texture {
-    unsigned int id;
-    string type;
-    string path;
+// Vertex formats a mesh can be uploaded in. The CPU copy (Mesh::vertices) is always a full Vertex;
+// the compact layouts are packed from it in setupMesh. Attribute locations stay the same:
+//   0 position    half4: xyz, w holds the bitangent sign (+1/-1)
+//   1 normal      snorm16x2, octahedral
+//   2 texcoords   half2
+//   3 tangent     snorm16x2, octahedral; bitangent = cross(normal, tangent) * position.w
+//   5 bone ids    int8x4 (skinned only; -1 = unused). A mesh with a bone id above 127 is uploaded
+//                 in VERTEX_LAYOUT_FULL instead, see Mesh::layout.
+//   6 weights     unorm8x4 (skinned only), summing to 1
+//   7-10          instance model matrix, only while drawn with DrawInstanced (all layouts)
+// Shaders that only read position and texcoords work unchanged. Normals and tangents must be
+// declared vec2 and decoded in the shader:
+//   vec3 octDecode(vec2 e)
+//   {
+//       vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//       if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+//       return normalize(v);
+//   }
+enum VertexLayout {
+    VERTEX_LAYOUT_FULL,            // Vertex as is: 88 bytes
+    VERTEX_LAYOUT_STATIC_COMPACT,  // CompactVertex: 20 bytes, no bone attributes
+    VERTEX_LAYOUT_SKINNED_COMPACT  // CompactSkinnedVertex: 28 bytes
+};
+
+struct CompactVertex {
+    uint16_t Position[4];
+    int16_t  Normal[2];
+    uint16_t TexCoords[2];
+    int16_t  Tangent[2];
+};
+
+struct CompactSkinnedVertex {
+    CompactVertex Base;
+    int8_t  m_BoneIDs[MAX_BONE_INFLUENCE];
+    uint8_t m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// maps a unit vector onto the [-1, 1] square of an octahedron unfolded into the plane
+inline glm::vec2 octEncode(glm::vec3 n)
+{
+    float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (length == 0.0f)
+        return glm::vec2(0.0f);
+    n /= length;
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+        e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return e;
+}
+
+inline CompactVertex packVertex(const Vertex& vertex)
+{
+    CompactVertex packed;
+    float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+    for (int i = 0; i < 3; i++)
+        packed.Position[i] = glm::packHalf1x16(vertex.Position[i]);
+    packed.Position[3] = glm::packHalf1x16(handedness);
+    glm::vec2 normal = octEncode(vertex.Normal), tangent = octEncode(vertex.Tangent);
+    for (int i = 0; i < 2; i++)
+    {
+        packed.Normal[i] = static_cast<int16_t>(glm::packSnorm1x16(normal[i]));
+        packed.TexCoords[i] = glm::packHalf1x16(vertex.TexCoords[i]);
+        packed.Tangent[i] = static_cast<int16_t>(glm::packSnorm1x16(tangent[i]));
+    }
+    return packed;
+}
+
+// whether every bone id fits the int8 of CompactSkinnedVertex
+inline bool fitsSkinnedCompact(const Vertex* vertices, size_t count)
+{
+    for (size_t v = 0; v < count; v++)
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+            if (vertices[v].m_BoneIDs[i] > 127)
+                return false;
+    return true;
+}
+
+// bone ids must fit (see fitsSkinnedCompact); larger ones are clamped
+inline CompactSkinnedVertex packSkinnedVertex(const Vertex& vertex)
+{
+    CompactSkinnedVertex packed;
+    packed.Base = packVertex(vertex);
+    // quantize the weights, then hand the rounding error to the largest one so they still sum to 1
+    int sum = 0, largest = 0;
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        packed.m_BoneIDs[i] = static_cast<int8_t>(vertex.m_BoneIDs[i] < 0 ? -1 : glm::min(vertex.m_BoneIDs[i], 127));
+        packed.m_Weights[i] = static_cast<uint8_t>(glm::clamp(std::lround(vertex.m_Weights[i] * 255.0f), 0L, 255L));
+        sum += packed.m_Weights[i];
+        if (packed.m_Weights[i] > packed.m_Weights[largest])
+            largest = i;
+    }
+    if (sum > 0)
+        packed.m_Weights[largest] = static_cast<uint8_t>(glm::clamp(packed.m_Weights[largest] + 255 - sum, 0, 255));
+    return packed;
+}
+
+// whether a mesh keeps its vertices and indices in memory once they are uploaded
+enum CpuDataPolicy {
+    CPU_DATA_KEEP,      // for code that reads Mesh::vertices / Mesh::indices after loading
+    CPU_DATA_RELEASE    // the GPU buffers are the only copy
+};
+
+// bytes per vertex in the GPU buffer of a layout
+inline size_t vertexStride(VertexLayout layout)
+{
+    return layout == VERTEX_LAYOUT_FULL ? sizeof(Vertex) : layout == VERTEX_LAYOUT_STATIC_COMPACT ? sizeof(CompactVertex) : sizeof(CompactSkinnedVertex);
+}
+
+// a level of detail: a range of Mesh::indices over the shared vertex buffer
+struct MeshLod {
+    unsigned int indexOffset, indexCount;
+    float error; // largest deviation from the full-detail surface, in model units
 };
 
 class Mesh {
 public:
     // mesh Data
-    vector<Vertex>       vertices;
-    vector<unsigned int> indices;
+    vector<Vertex>       vertices;  // empty after upload under CPU_DATA_RELEASE
+    vector<unsigned int> indices;   // all levels of detail back to back, full detail first; empty under CPU_DATA_RELEASE
+    size_t               vertexCount, indexCount; // sizes of the GPU buffers, valid whatever the policy
     vector<Texture>      textures;
+    Material             material;  // textures with their texture units resolved
+    vector<MeshLod>      lods;      // lods[0] is the full-detail mesh
+    VertexLayout         layout;    // as uploaded: VERTEX_LAYOUT_FULL when bone ids do not fit the skinned compact one
     unsigned int VAO;
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor; without lods, all indices form a single level. Pass the vectors with std::move
+    // to hand them over without a copy.
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexLayout layout = VERTEX_LAYOUT_FULL,
+         vector<MeshLod> lods = {}, CpuDataPolicy cpuData = CPU_DATA_KEEP)
+        : vertices(std::move(vertices)), indices(std::move(indices)), vertexCount(this->vertices.size()), indexCount(this->indices.size()),
+          textures(std::move(textures)), material(this->textures), layout(layout)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->lods = lods.empty() ? vector<MeshLod>{ { 0, static_cast<unsigned int>(indexCount), 0.0f } } : std::move(lods);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), vertexCount, this->indices.data(), indexCount);
+        if (cpuData == CPU_DATA_RELEASE)
+            ReleaseCpuData();
     }
 
+    // constructor for vertex/index data that is already laid out in memory (e.g. a mapped compiled
+    // model): the buffers are filled straight from the given ranges
+    Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, vector<Texture> textures,
+         VertexLayout layout = VERTEX_LAYOUT_FULL, vector<MeshLod> lods = {}, CpuDataPolicy cpuData = CPU_DATA_KEEP)
+        : vertexCount(vertexCount), indexCount(indexCount), textures(std::move(textures)), material(this->textures), layout(layout)
+    {
+        if (cpuData == CPU_DATA_KEEP)
+        {
+            this->vertices.assign(vertices, vertices + vertexCount);
+            this->indices.assign(indices, indices + indexCount);
+        }
+        this->lods = lods.empty() ? vector<MeshLod>{ { 0, static_cast<unsigned int>(indexCount), 0.0f } } : std::move(lods);
+
+        setupMesh(vertices, vertexCount, indices, indexCount);
+    }
+
+    // frees the CPU copies of vertices and indices; the GPU buffers stay as they are
+    void ReleaseCpuData()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+    }
+
+    unsigned int VertexBuffer() const { return VBO; }
+    unsigned int IndexBuffer() const { return EBO; }
+
     // render the mesh
     void Draw(Shader &shader) 
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
+        // samplers have fixed units (see MaterialBindings), so only the textures need binding
+        MaterialBindings::Resolve(shader.ID);
+        material.Bind();
+        DrawGeometry();
+    }
+
+    // draws the full-detail mesh with whatever textures are bound
+    void DrawGeometry() const
+    {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_INT, (void*)(lods[0].indexOffset * sizeof(unsigned int)));
+        glBindVertexArray(0);
+    }
+
+    // draws count instances of the full-detail mesh with whatever textures are bound. Their model
+    // matrices come from the bound GL_ARRAY_BUFFER, a mat4 per instance from offset bytes on, into
+    // locations INSTANCE_MATRIX_ATTRIBUTE to INSTANCE_MATRIX_ATTRIBUTE + 3:
+    //     layout (location = 7) in mat4 aInstanceMatrix;
+    void DrawInstanced(size_t offset, GLsizei count) const
+    {
+        glBindVertexArray(VAO);
+        for (unsigned int column = 0; column < 4; column++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            GLuint location = INSTANCE_MATRIX_ATTRIBUTE + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location, 1);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElementsInstanced(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_INT, (void*)(lods[0].indexOffset * sizeof(unsigned int)), count);
         glBindVertexArray(0);
+    }
+
+    // fills the bound GL_ARRAY_BUFFER with vertices in the given layout and points the bound VAO's
+    // attributes at it
+    static void SetupVertexBuffer(VertexLayout layout, const Vertex* vertexData, size_t vertexCount)
+    {
+        if (layout == VERTEX_LAYOUT_FULL)
+        {
+            // A great thing about structs is that their memory layout is sequential for all its items.
+            // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+            // again translates to 3/2 floats which translates to a byte array.
+            glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);
+        }
+        else if (layout == VERTEX_LAYOUT_STATIC_COMPACT)
+        {
+            // pack into the compact format
+            vector<CompactVertex> packed(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++)
+                packed[i] = packVertex(vertexData[i]);
+            glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(CompactVertex), packed.data(), GL_STATIC_DRAW);
+        }
+        else
+        {
+            vector<CompactSkinnedVertex> packed(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++)
+                packed[i] = packSkinnedVertex(vertexData[i]);
+            glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(CompactSkinnedVertex), packed.data(), GL_STATIC_DRAW);
+        }
+        SetupVertexAttributes(layout);
+    }
+
+    // points the bound VAO's attributes at the bound GL_ARRAY_BUFFER, which holds vertices in the given layout
+    static void SetupVertexAttributes(VertexLayout layout)
+    {
+        if (layout == VERTEX_LAYOUT_FULL)
+        {
+            // set the vertex attribute pointers
+            // vertex Positions
+            glEnableVertexAttribArray(0);	
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // vertex normals
+            glEnableVertexAttribArray(1);	
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            // vertex texture coords
+            glEnableVertexAttribArray(2);	
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+            // vertex tangent
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+            // vertex bitangent
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+            // ids
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+
+            // weights
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+            return;
+        }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        // both compact formats share the leading CompactVertex fields
+        GLsizei stride = static_cast<GLsizei>(vertexStride(layout));
+        if (layout == VERTEX_LAYOUT_SKINNED_COMPACT)
+        {
+            // ids
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_BYTE, stride, (void*)offsetof(CompactSkinnedVertex, m_BoneIDs));
+            // weights
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(CompactSkinnedVertex, m_Weights));
+        }
+        // vertex Positions (w = bitangent sign)
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, Position));
+        // vertex normals (octahedral)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, Normal));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, TexCoords));
+        // vertex tangent (octahedral)
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, Tangent));
     }
 
 private:
@@ -99,47 +331,27 @@ private:
     unsigned int VBO, EBO;
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount)
     {
+        if (layout == VERTEX_LAYOUT_SKINNED_COMPACT && !fitsSkinnedCompact(vertexData, vertexCount))
+        {
+            std::cout << "WARNING::MESH: bone ids above 127 do not fit the skinned compact layout, uploading the full one "
+                         "(draw it with a shader reading full vertices)" << std::endl;
+            layout = VERTEX_LAYOUT_FULL;
+        }
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
         glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
+
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+        SetupVertexBuffer(layout, vertexData, vertexCount);
         glBindVertexArray(0);
     }
 };
@@ -0,0 +1,348 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// Import-time optimization of indexed triangle lists for the GPU's vertex pipeline:
+//   1. Weld            merges bit-identical vertices
+//   2. OptimizeVertexCache   Tipsify (Sander et al. 2007) triangle order for the post-transform cache
+//   3. OptimizeOverdraw      reorders Tipsify's clusters so outward-facing ones are drawn first
+//   4. OptimizeVertexFetch   lays vertices out in the order the indices first reference them
+// AnalyzeVertexCache simulates a FIFO post-transform cache, so every step can be measured on the CPU.
+class MeshOptimizer
+{
+public:
+    static const unsigned int CACHE_SIZE = 16; // FIFO entries assumed by the simulator and by Tipsify
+
+    struct CacheStats
+    {
+        float acmr = 0.0f; // average cache miss ratio: transformed vertices per triangle (0.5 ideal, 3 worst)
+        float atvr = 0.0f; // average transform to vertex ratio: transformed vertices per unique vertex (1 ideal)
+    };
+
+    // summed over all meshes of a model: totals weighted by triangle and vertex counts
+    struct Report
+    {
+        size_t meshes = 0, triangles = 0, verticesBefore = 0, verticesAfter = 0;
+        double missesBefore = 0, missesAfter = 0;
+
+        void Add(size_t triangleCount, size_t before, size_t after, const CacheStats& statsBefore, const CacheStats& statsAfter)
+        {
+            meshes++;
+            triangles += triangleCount;
+            verticesBefore += before;
+            verticesAfter += after;
+            missesBefore += statsBefore.acmr * triangleCount;
+            missesAfter += statsAfter.acmr * triangleCount;
+        }
+        void Add(const Report& other)
+        {
+            meshes += other.meshes;
+            triangles += other.triangles;
+            verticesBefore += other.verticesBefore;
+            verticesAfter += other.verticesAfter;
+            missesBefore += other.missesBefore;
+            missesAfter += other.missesAfter;
+        }
+        // the model-wide statistics before and after optimization
+        CacheStats Before() const { return stats(missesBefore, verticesBefore); }
+        CacheStats After() const { return stats(missesAfter, verticesAfter); }
+
+        void Print(const string& name) const
+        {
+            if (triangles == 0)
+                return;
+            CacheStats before = Before(), after = After();
+            std::cout << "MESH_OPTIMIZER: " << name << ": " << meshes << " meshes, " << triangles << " triangles, vertices "
+                      << verticesBefore << " -> " << verticesAfter << ", ACMR " << before.acmr << " -> " << after.acmr
+                      << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+        }
+
+    private:
+        CacheStats stats(double misses, size_t vertices) const
+        {
+            CacheStats result;
+            result.acmr = triangles ? static_cast<float>(misses / triangles) : 0.0f;
+            result.atvr = vertices ? static_cast<float>(misses / vertices) : 0.0f;
+            return result;
+        }
+    };
+
+    // runs every pass on a mesh and records its before/after statistics
+    static void Optimize(vector<Vertex>& vertices, vector<unsigned int>& indices, Report* report = nullptr)
+    {
+        size_t verticesBefore = vertices.size();
+        CacheStats before = AnalyzeVertexCache(indices, vertices.size());
+        Weld(vertices, indices);
+        vector<unsigned int> clusters;
+        OptimizeVertexCache(indices, vertices.size(), &clusters);
+        OptimizeOverdraw(indices, vertices, clusters);
+        OptimizeVertexFetch(vertices, indices);
+        if (report != nullptr)
+            report->Add(indices.size() / 3, verticesBefore, vertices.size(), before, AnalyzeVertexCache(indices, vertices.size()));
+    }
+
+    // merges vertices whose attributes are bit-identical and drops unreferenced ones
+    static void Weld(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        struct Hash
+        {
+            size_t operator()(const Vertex* v) const
+            {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(v);
+                uint64_t hash = 14695981039346656037ull; // FNV-1a
+                for (size_t i = 0; i < sizeof(Vertex); i++)
+                    hash = (hash ^ bytes[i]) * 1099511628211ull;
+                return static_cast<size_t>(hash);
+            }
+        };
+        struct Equal
+        {
+            bool operator()(const Vertex* a, const Vertex* b) const { return std::memcmp(a, b, sizeof(Vertex)) == 0; }
+        };
+        std::unordered_map<const Vertex*, unsigned int, Hash, Equal> unique;
+        unique.reserve(vertices.size());
+        vector<unsigned int> remap(vertices.size(), ~0u);
+        vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == ~0u)
+            {
+                auto found = unique.emplace(&vertices[index], static_cast<unsigned int>(welded.size()));
+                if (found.second)
+                    welded.push_back(vertices[index]);
+                remap[index] = found.first->second;
+            }
+            index = remap[index];
+        }
+        vertices.swap(welded);
+    }
+
+    // Tipsify: fans around a vertex that is still in the cache, falling back to the most recently
+    // used live vertex at dead ends. The triangle index at which each dead end happened is appended
+    // to clusters (starting with 0), which the overdraw pass uses as reorderable units.
+    static void OptimizeVertexCache(vector<unsigned int>& indices, size_t vertexCount, vector<unsigned int>* clusters = nullptr)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (clusters != nullptr)
+            clusters->assign(1, 0);
+        if (triangleCount == 0)
+            return;
+
+        // vertex -> triangle adjacency
+        vector<unsigned int> live(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(indices.size());
+        for (unsigned int index : indices)
+            live[index]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] = offsets[v] + live[v];
+        {
+            vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++)
+                adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        vector<unsigned int> cacheTime(vertexCount, 0), deadEnds, candidates;
+        vector<bool> emitted(triangleCount, false);
+        vector<unsigned int> result;
+        result.reserve(indices.size());
+        unsigned int time = CACHE_SIZE + 1;
+        size_t cursor = 0;
+        long fan = 0;
+        while (fan >= 0)
+        {
+            candidates.clear();
+            for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; a++)
+            {
+                unsigned int t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[t * 3 + k];
+                    result.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (time - cacheTime[v] > CACHE_SIZE)
+                        cacheTime[v] = time++;
+                }
+                emitted[t] = true;
+            }
+
+            // next fanning vertex: the live candidate that will still be cached after its remaining triangles
+            fan = -1;
+            int best = -1;
+            for (unsigned int v : candidates)
+            {
+                if (live[v] == 0)
+                    continue;
+                int priority = 0;
+                if (time - cacheTime[v] + 2 * live[v] <= CACHE_SIZE)
+                    priority = static_cast<int>(time - cacheTime[v]);
+                if (priority > best)
+                {
+                    best = priority;
+                    fan = v;
+                }
+            }
+            if (fan < 0)
+            {
+                // dead end: take a recently touched vertex, or the next live vertex in input order
+                while (!deadEnds.empty() && fan < 0)
+                {
+                    unsigned int v = deadEnds.back();
+                    deadEnds.pop_back();
+                    if (live[v] > 0)
+                        fan = v;
+                }
+                while (fan < 0 && cursor < vertexCount)
+                {
+                    if (live[cursor] > 0)
+                        fan = static_cast<long>(cursor);
+                    cursor++;
+                }
+                if (fan >= 0 && clusters != nullptr && result.size() / 3 > clusters->back())
+                    clusters->push_back(static_cast<unsigned int>(result.size() / 3));
+            }
+        }
+        indices.swap(result);
+    }
+
+    // Reorders clusters of triangles (from OptimizeVertexCache) front to back as seen from outside
+    // the mesh: clusters whose centroid lies far along their own average normal go first, so they
+    // occlude the rest. Clusters are first split where their local ACMR is already within
+    // `threshold` of the mesh's, which keeps most of the cache efficiency.
+    static void OptimizeOverdraw(vector<unsigned int>& indices, const vector<Vertex>& vertices, vector<unsigned int> clusters, float threshold = 1.05f)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return;
+        if (clusters.empty())
+            clusters.push_back(0);
+
+        // soft boundaries
+        float meshAcmr = AnalyzeVertexCache(indices, vertices.size()).acmr;
+        vector<unsigned int> split;
+        vector<unsigned int> cacheTime(vertices.size(), 0);
+        unsigned int time = CACHE_SIZE + 1;
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+            size_t start = clusters[c], misses = 0;
+            split.push_back(static_cast<unsigned int>(start));
+            time += CACHE_SIZE + 1; // fresh cache for every cluster
+            for (size_t t = start; t < end; t++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[t * 3 + k];
+                    if (time - cacheTime[v] > CACHE_SIZE)
+                    {
+                        cacheTime[v] = time++;
+                        misses++;
+                    }
+                }
+                if (t + 1 < end && misses <= threshold * meshAcmr * (t + 1 - start))
+                {
+                    split.push_back(static_cast<unsigned int>(t + 1));
+                    start = t + 1;
+                    misses = 0;
+                    time += CACHE_SIZE + 1;
+                }
+            }
+        }
+
+        // mesh centroid and per-cluster sort key, area weighted
+        auto position = [&](size_t i) { return vertices[indices[i]].Position; };
+        glm::vec3 meshCenter(0.0f);
+        float meshArea = 0.0f;
+        vector<glm::vec3> clusterCenter(split.size(), glm::vec3(0.0f)), clusterNormal(split.size(), glm::vec3(0.0f));
+        vector<float> clusterArea(split.size(), 0.0f);
+        for (size_t c = 0; c < split.size(); c++)
+        {
+            size_t end = c + 1 < split.size() ? split[c + 1] : triangleCount;
+            for (size_t t = split[c]; t < end; t++)
+            {
+                glm::vec3 p0 = position(t * 3), p1 = position(t * 3 + 1), p2 = position(t * 3 + 2);
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+                glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+                clusterCenter[c] += center * area;
+                clusterNormal[c] += normal;
+                clusterArea[c] += area;
+            }
+            meshCenter += clusterCenter[c];
+            meshArea += clusterArea[c];
+        }
+        if (meshArea > 0.0f)
+            meshCenter /= meshArea;
+        vector<float> key(split.size(), 0.0f);
+        vector<unsigned int> order(split.size());
+        for (size_t c = 0; c < split.size(); c++)
+        {
+            order[c] = static_cast<unsigned int>(c);
+            if (clusterArea[c] > 0.0f && glm::length(clusterNormal[c]) > 0.0f)
+                key[c] = glm::dot(clusterCenter[c] / clusterArea[c] - meshCenter, glm::normalize(clusterNormal[c]));
+        }
+        std::stable_sort(order.begin(), order.end(), [&key](unsigned int a, unsigned int b) { return key[a] > key[b]; });
+
+        vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (unsigned int c : order)
+        {
+            size_t end = c + 1 < split.size() ? split[c + 1] : triangleCount;
+            result.insert(result.end(), indices.begin() + split[c] * 3, indices.begin() + end * 3);
+        }
+        indices.swap(result);
+    }
+
+    // renumbers vertices in order of first use, so the vertex buffer is read front to back
+    static void OptimizeVertexFetch(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        vector<unsigned int> remap(vertices.size(), ~0u);
+        vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == ~0u)
+            {
+                remap[index] = static_cast<unsigned int>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+    }
+
+    // simulates a FIFO post-transform cache of CACHE_SIZE entries
+    static CacheStats AnalyzeVertexCache(const vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE)
+    {
+        CacheStats stats;
+        if (indices.empty() || vertexCount == 0)
+            return stats;
+        vector<unsigned int> insertedAt(vertexCount, 0);
+        unsigned int time = cacheSize + 1, misses = 0;
+        for (unsigned int index : indices)
+        {
+            if (time - insertedAt[index] > cacheSize)
+            {
+                insertedAt[index] = time++;
+                misses++;
+            }
+        }
+        stats.acmr = float(misses) / (indices.size() / 3);
+        stats.atvr = float(misses) / vertexCount;
+        return stats;
+    }
+};
+#endif
@@ -0,0 +1,269 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Quadric error metric simplification (Garland & Heckbert 1997) by edge collapse onto existing
+// vertices, so every level of detail is just another index list over the original vertex buffer.
+// Vertices on open borders and on attribute seams (several vertices sharing a position) are
+// locked, which keeps silhouettes and texture seams intact at the cost of some reduction.
+class MeshSimplifier
+{
+public:
+    static const unsigned int MAX_LODS = 4;
+
+    // Appends up to MAX_LODS - 1 coarser levels to indices, each with `ratio` of the previous
+    // level's triangles, and returns the level table (level 0 = the indices passed in). Stops early
+    // once a level would drop below minTriangles or simplification stalls.
+    static vector<MeshLod> BuildLods(const vector<Vertex>& vertices, vector<unsigned int>& indices, float ratio = 0.5f, size_t minTriangles = 64)
+    {
+        vector<MeshLod> lods = { { 0, static_cast<unsigned int>(indices.size()), 0.0f } };
+        vector<size_t> targets;
+        for (size_t triangles = indices.size() / 3; targets.size() + 1 < MAX_LODS; )
+        {
+            triangles = static_cast<size_t>(triangles * ratio);
+            if (triangles < minTriangles)
+                break;
+            targets.push_back(triangles * 3);
+        }
+        if (targets.empty())
+            return lods;
+
+        vector<vector<unsigned int>> levels;
+        vector<float> errors;
+        Simplify(vertices, vector<unsigned int>(indices), targets, levels, errors);
+        size_t previous = indices.size();
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            // a level that is barely smaller than the one before isn't worth a draw-time switch
+            if (levels[i].size() > previous * (1.0f + ratio) / 2.0f)
+                break;
+            MeshOptimizer::OptimizeVertexCache(levels[i], vertices.size());
+            lods.push_back({ static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(levels[i].size()), errors[i] });
+            indices.insert(indices.end(), levels[i].begin(), levels[i].end());
+            previous = levels[i].size();
+        }
+        return lods;
+    }
+
+    // Collapses edges in order of increasing quadric error. Every time the index count reaches the
+    // next entry of targetIndexCounts (descending), a snapshot goes to levels and its error (square
+    // root of the largest collapse cost, in model units) to errors. Fewer levels come back if the
+    // mesh runs out of collapsible edges.
+    static void Simplify(const vector<Vertex>& vertices, vector<unsigned int> indices, const vector<size_t>& targetIndexCounts,
+                         vector<vector<unsigned int>>& levels, vector<float>& errors)
+    {
+        const size_t vertexCount = vertices.size();
+        vector<unsigned int> position = positionClasses(vertices);
+
+        // seams: more than one vertex at a position
+        vector<unsigned int> classSize(vertexCount, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            classSize[position[v]]++;
+        vector<bool> locked(vertexCount, false);
+        for (size_t v = 0; v < vertexCount; v++)
+            locked[v] = classSize[position[v]] > 1;
+        // borders: edges (between positions) used by exactly one triangle
+        {
+            std::unordered_map<uint64_t, unsigned int> edgeUse;
+            edgeUse.reserve(indices.size());
+            for (size_t i = 0; i < indices.size(); i += 3)
+                for (int k = 0; k < 3; k++)
+                    edgeUse[edgeKey(position[indices[i + k]], position[indices[i + (k + 1) % 3]])]++;
+            for (size_t i = 0; i < indices.size(); i += 3)
+                for (int k = 0; k < 3; k++)
+                    if (edgeUse[edgeKey(position[indices[i + k]], position[indices[i + (k + 1) % 3]])] != 2)
+                        locked[indices[i + k]] = locked[indices[i + (k + 1) % 3]] = true;
+        }
+
+        // plane quadrics of the surrounding triangles
+        vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            glm::vec3 p0 = vertices[indices[i]].Position, p1 = vertices[indices[i + 1]].Position, p2 = vertices[indices[i + 2]].Position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length == 0.0f)
+                continue;
+            normal /= length;
+            Quadric plane(normal, -glm::dot(normal, p0));
+            for (int k = 0; k < 3; k++)
+                quadrics[indices[i + k]].Add(plane);
+        }
+
+        struct Collapse
+        {
+            unsigned int from, to;
+            double cost;
+        };
+        vector<Collapse> candidates;
+        vector<unsigned int> remap(vertexCount), adjacencyOffsets, adjacency;
+        vector<bool> touched(vertexCount);
+        double maxCost = 0.0;
+        size_t target = 0;
+        while (target < targetIndexCounts.size())
+        {
+            if (indices.size() <= targetIndexCounts[target])
+            {
+                levels.push_back(indices);
+                errors.push_back(static_cast<float>(std::sqrt(maxCost)));
+                target++;
+                continue;
+            }
+
+            // candidate collapses along every edge, cheaper direction only
+            candidates.clear();
+            for (size_t i = 0; i < indices.size(); i += 3)
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int a = indices[i + k], b = indices[i + (k + 1) % 3];
+                    if (a > b || locked[a] || locked[b]) // each interior edge is seen from both triangles; keep one
+                        continue;
+                    Quadric q = quadrics[a];
+                    q.Add(quadrics[b]);
+                    double toB = q.Evaluate(vertices[b].Position), toA = q.Evaluate(vertices[a].Position);
+                    candidates.push_back(toB <= toA ? Collapse{ a, b, toB } : Collapse{ b, a, toA });
+                }
+            if (candidates.empty())
+                break;
+            std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+            buildAdjacency(indices, vertexCount, adjacencyOffsets, adjacency);
+            std::fill(touched.begin(), touched.end(), false);
+            for (size_t v = 0; v < vertexCount; v++)
+                remap[v] = static_cast<unsigned int>(v);
+
+            // each collapse removes about two triangles
+            size_t budget = (indices.size() - targetIndexCounts[target]) / 6 + 1, collapsed = 0;
+            for (const Collapse& collapse : candidates)
+            {
+                if (collapsed >= budget)
+                    break;
+                if (touched[collapse.from] || touched[collapse.to] || flips(vertices, indices, adjacencyOffsets, adjacency, collapse.from, collapse.to))
+                    continue;
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to].Add(quadrics[collapse.from]);
+                maxCost = std::max(maxCost, collapse.cost);
+                collapsed++;
+                // the moved vertex's whole neighborhood is now stale for this pass
+                for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+                    for (int k = 0; k < 3; k++)
+                        touched[indices[adjacency[a] * 3 + k]] = true;
+            }
+            if (collapsed == 0)
+                break;
+
+            // apply and drop the triangles that degenerated
+            size_t write = 0;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+                if (a == b || b == c || a == c)
+                    continue;
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+            indices.resize(write);
+        }
+    }
+
+private:
+    // symmetric 4x4 matrix, upper triangle
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        Quadric() = default;
+        Quadric(glm::vec3 n, float d)
+            : a2(n.x * n.x), ab(n.x * n.y), ac(n.x * n.z), ad(n.x * d), b2(n.y * n.y), bc(n.y * n.z), bd(n.y * d), c2(n.z * n.z), cd(n.z * d), d2(d * d)
+        {
+        }
+        void Add(const Quadric& q)
+        {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+            bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        }
+        // sum of squared distances of p to the accumulated planes
+        double Evaluate(glm::vec3 p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double error = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                         + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                         + c2 * z * z + 2 * cd * z + d2;
+            return error > 0.0 ? error : 0.0;
+        }
+    };
+
+    static uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+    }
+
+    // for every vertex, the first vertex with a bit-identical position
+    static vector<unsigned int> positionClasses(const vector<Vertex>& vertices)
+    {
+        struct Hash
+        {
+            size_t operator()(const glm::vec3& p) const
+            {
+                uint32_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        std::unordered_map<glm::vec3, unsigned int, Hash> first;
+        first.reserve(vertices.size());
+        vector<unsigned int> classes(vertices.size());
+        for (size_t v = 0; v < vertices.size(); v++)
+            classes[v] = first.emplace(vertices[v].Position, static_cast<unsigned int>(v)).first->second;
+        return classes;
+    }
+
+    static void buildAdjacency(const vector<unsigned int>& indices, size_t vertexCount, vector<unsigned int>& offsets, vector<unsigned int>& adjacency)
+    {
+        offsets.assign(vertexCount + 1, 0);
+        for (unsigned int index : indices)
+            offsets[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        adjacency.resize(indices.size());
+        vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    // would moving `from` onto `to` turn any of from's remaining triangles over?
+    static bool flips(const vector<Vertex>& vertices, const vector<unsigned int>& indices, const vector<unsigned int>& offsets,
+                      const vector<unsigned int>& adjacency, unsigned int from, unsigned int to)
+    {
+        for (unsigned int a = offsets[from]; a < offsets[from + 1]; a++)
+        {
+            const unsigned int* triangle = &indices[adjacency[a] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                continue; // collapses away
+            glm::vec3 p[3], moved[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = vertices[triangle[k]].Position;
+                moved[k] = triangle[k] == from ? vertices[to].Position : p[k];
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+                return true;
+        }
+        return false;
+    }
+};
+#endif
@@ -13,96 +13,472 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/model_cache.h>
+#include <learnopengl/assimp_glm_helpers.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/load_profile.h>
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+// CPU-side result of processing one aiMesh, before anything is uploaded to GL
+struct MeshData {
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;   // all levels of detail, see Mesh::indices
+    vector<MeshLod>      lods;
+    glm::vec3 boundsMin, boundsMax;
+    MeshOptimizer::Report optimization;
+};
+
+// CPU-side result of reading a model file, either mapped from the model cache or imported through
+// ASSIMP. Building it makes no GL calls, so it can happen on a worker thread (see ModelStreamer).
+struct ModelImport {
+    unique_ptr<CompiledModel> compiled;   // set when the model cache had an up-to-date entry
+    vector<MeshData> meshes;              // otherwise, the imported meshes
+    vector<unsigned int> meshMaterials;   // material of each mesh
+    vector<vector<Texture>> materials;    // textures of each material; ids are filled in by the GL phase
+    vector<ModelNode> nodes;
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+    MeshOptimizer::Report optimization;
+
+    size_t MeshCount() const { return meshMaterials.size(); }
+};
+
 class Model 
 {
 public:
     // model data 
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Texture> textures_loaded;	// textures this model holds in the shared TextureCache, one per distinct path
     vector<Mesh>    meshes;
+    vector<ModelNode> nodes;    // node hierarchy, parents first
+    glm::vec3 boundsMin, boundsMax; // bounds of all meshes in model space
     string directory;
     bool gammaCorrection;
+    VertexLayout vertexLayout;  // GPU vertex format of all meshes
+    CpuDataPolicy cpuData;      // whether meshes keep their vertices and indices after upload
+    MeshOptimizer::Report optimization; // vertex cache statistics of the import (empty when loaded from the model cache)
+
+    // meshes that bind the same textures, drawn together so each material is bound once per Draw
+    struct MaterialGroup {
+        Material material;
+        vector<unsigned int> meshes;
+        unsigned int firstCommand; // first draw command of the group, see BuildDrawBatches
+    };
+    vector<MaterialGroup> materialGroups;
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // constructor, expects a filepath to a 3D model. Meshes drop their CPU copies once uploaded unless
+    // cpuData is CPU_DATA_KEEP; boundsMin/boundsMax are available either way.
+    Model(string const &path, bool gamma = false, VertexLayout layout = VERTEX_LAYOUT_FULL, CpuDataPolicy cpuData = CPU_DATA_RELEASE)
+        : gammaCorrection(gamma), vertexLayout(layout), cpuData(cpuData)
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
+    // textures are reference counted in the shared cache, so a model is moved rather than copied
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&&) = default;
+
+    ~Model()
+    {
+        for (const Texture &texture : textures_loaded)
+            TextureCache::Shared().Release(texture.id);
+    }
+
+    // draws the model, and thus all its meshes, one material group at a time
     void Draw(Shader &shader)
     {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        MaterialBindings::Resolve(shader.ID);
+        if (batch.VAO != 0)
+        {
+            glBindVertexArray(batch.VAO);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.commands);
+        }
+        for(const MaterialGroup &group : materialGroups)
+        {
+            group.material.Bind();
+            if (batch.VAO != 0)
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(group.firstCommand * sizeof(DrawCommand)),
+                                            static_cast<GLsizei>(group.meshes.size()), 0);
+            else
+                for(unsigned int mesh : group.meshes)
+                    meshes[mesh].DrawGeometry();
+        }
+        if (batch.VAO != 0)
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            glBindVertexArray(0);
+        }
+    }
+
+    // draws count instances of the model, one instanced draw per mesh; the model matrices are read
+    // from instanceBuffer, a mat4 per instance from offset bytes on (see Mesh::DrawInstanced)
+    void DrawInstanced(Shader &shader, unsigned int instanceBuffer, size_t offset, GLsizei count)
+    {
+        MaterialBindings::Resolve(shader.ID);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for(const MaterialGroup &group : materialGroups)
+        {
+            group.material.Bind();
+            for(unsigned int mesh : group.meshes)
+                meshes[mesh].DrawInstanced(offset, count);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // copies the full-detail geometry of all meshes into one vertex and one index buffer, after which
+    // Draw issues a single glMultiDrawElementsIndirect per material group. The copy happens on the GPU,
+    // so it works after the CPU data was released. Costs a second copy of the geometry in video memory
+    // (the per-mesh VAOs stay usable, e.g. for instancing) and needs OpenGL 4.3.
+    bool BuildDrawBatches()
+    {
+        if (!GLAD_GL_VERSION_4_3 || meshes.empty())
+            return false;
+        // a mesh that fell back to another layout (see Mesh::layout) cannot share the batch buffer
+        for(const Mesh &mesh : meshes)
+            if (mesh.layout != vertexLayout)
+                return false;
+        const size_t stride = vertexStride(vertexLayout);
+        size_t vertexCount = 0, indexCount = 0;
+        vector<DrawCommand> commands;
+        for(const MaterialGroup &group : materialGroups)
+            for(unsigned int i : group.meshes)
+            {
+                commands.push_back({ meshes[i].lods[0].indexCount, 1, static_cast<unsigned int>(indexCount), static_cast<int>(vertexCount), 0 });
+                vertexCount += meshes[i].vertexCount;
+                indexCount += meshes[i].lods[0].indexCount;
+            }
+
+        batch = DrawBatch();
+        glGenVertexArrays(1, &batch.VAO);
+        glGenBuffers(1, &batch.VBO);
+        glGenBuffers(1, &batch.EBO);
+        glGenBuffers(1, &batch.commands);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, batch.VBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, vertexCount * stride, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, batch.EBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, indexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+        unsigned int command = 0;
+        for(const MaterialGroup &group : materialGroups)
+            for(unsigned int i : group.meshes)
+            {
+                const Mesh &mesh = meshes[i];
+                const DrawCommand &draw = commands[command++];
+                glBindBuffer(GL_COPY_READ_BUFFER, mesh.VertexBuffer());
+                glBindBuffer(GL_COPY_WRITE_BUFFER, batch.VBO);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, draw.baseVertex * stride, mesh.vertexCount * stride);
+                glBindBuffer(GL_COPY_READ_BUFFER, mesh.IndexBuffer());
+                glBindBuffer(GL_COPY_WRITE_BUFFER, batch.EBO);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, mesh.lods[0].indexOffset * sizeof(unsigned int),
+                                    draw.firstIndex * sizeof(unsigned int), draw.count * sizeof(unsigned int));
+            }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        glBindVertexArray(batch.VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.EBO);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.VBO);
+        Mesh::SetupVertexAttributes(vertexLayout);
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.commands);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        return true;
+    }
+
+    // simplification error of each level of detail over all meshes (meshes with fewer levels use their coarsest one)
+    vector<float> LodErrors() const
+    {
+        vector<float> errors;
+        for(const Mesh &mesh : meshes)
+        {
+            if (errors.size() < mesh.lods.size())
+                errors.resize(mesh.lods.size(), 0.0f);
+            for(unsigned int level = 0; level < errors.size(); level++)
+                errors[level] = std::max(errors[level], mesh.lods[std::min<size_t>(level, mesh.lods.size() - 1)].error);
+        }
+        return errors;
     }
     
 private:
+    static const unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+    bool streamTextures = false;      // textures start as placeholders and stream in, see ModelStreamer
+
+    friend class ModelStreamer;
+    struct StreamTag {};
+
+    // an empty model that ModelStreamer fills step by step
+    Model(StreamTag, string const &path, bool gamma, VertexLayout layout, CpuDataPolicy cpuData)
+        : directory(path.substr(0, path.find_last_of('/'))), gammaCorrection(gamma), vertexLayout(layout), cpuData(cpuData), streamTextures(true)
+    {
+    }
+
+    // layout of a glMultiDrawElementsIndirect command
+    struct DrawCommand {
+        unsigned int count, instanceCount, firstIndex;
+        int baseVertex;
+        unsigned int baseInstance;
+    };
+
+    // merged geometry built by BuildDrawBatches; owns its GL objects
+    struct DrawBatch {
+        unsigned int VAO = 0, VBO = 0, EBO = 0, commands = 0;
+
+        DrawBatch() = default;
+        DrawBatch(DrawBatch &&other) { *this = std::move(other); }
+        DrawBatch &operator=(DrawBatch &&other)
+        {
+            std::swap(VAO, other.VAO);
+            std::swap(VBO, other.VBO);
+            std::swap(EBO, other.EBO);
+            std::swap(commands, other.commands);
+            return *this;
+        }
+        ~DrawBatch()
+        {
+            if (VAO == 0)
+                return;
+            glDeleteVertexArrays(1, &VAO);
+            unsigned int buffers[3] = { VBO, EBO, commands };
+            glDeleteBuffers(3, buffers);
+        }
+    };
+    DrawBatch batch;
+
+    // groups meshes by their texture bindings, in order of first appearance
+    void groupMaterials()
+    {
+        materialGroups.clear();
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            auto group = std::find_if(materialGroups.begin(), materialGroups.end(),
+                                      [&](const MaterialGroup &g) { return g.material.SameBindings(meshes[i].material); });
+            if (group == materialGroups.end())
+            {
+                materialGroups.push_back({ meshes[i].material, {}, 0 });
+                group = materialGroups.end() - 1;
+            }
+            group->meshes.push_back(i);
+        }
+        unsigned int command = 0;
+        for(MaterialGroup &group : materialGroups)
+        {
+            group.firstCommand = command;
+            command += static_cast<unsigned int>(group.meshes.size());
+        }
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        ModelImport import;
+        if (!importModel(path, import))
+            return;
+        beginUpload(import);
+        for(unsigned int i = 0; i < import.MeshCount(); i++)
+            uploadMesh(import, i);
+        finishUpload(path, import);
+    }
+
+    // CPU phase: maps the model cache entry or imports the file through ASSIMP. Makes no GL calls,
+    // so it may run on a worker thread.
+    static bool importModel(string const &path, ModelImport &import)
+    {
+        // a compiled model written by an earlier run skips the import altogether
+        auto compiled = std::make_unique<CompiledModel>();
+        bool cached;
+        {
+            LoadProfile::Timer timer(LoadProfile::CACHE_OPEN);
+            cached = ModelCache::Open(path, importFlags, *compiled);
+        }
+        if (cached)
+        {
+            import.materials.resize(compiled->MaterialCount());
+            for(unsigned int i = 0; i < compiled->MaterialCount(); i++)
+                for(unsigned int j = 0; j < compiled->Material(i).textureCount; j++)
+                {
+                    const CompiledModel::TextureRecord &texture = compiled->MaterialTexture(i, j);
+                    import.materials[i].push_back({ 0, compiled->String(texture.type), compiled->String(texture.path) });
+                }
+            for(unsigned int i = 0; i < compiled->MeshCount(); i++)
+                import.meshMaterials.push_back(compiled->MeshInfo(i).material);
+
+            import.nodes.resize(compiled->NodeCount());
+            for(unsigned int i = 0; i < compiled->NodeCount(); i++)
+            {
+                const CompiledModel::NodeRecord &node = compiled->Node(i);
+                import.nodes[i].name = compiled->String(node.name);
+                import.nodes[i].parent = node.parent;
+                import.nodes[i].transform = node.transform;
+                for(unsigned int j = 0; j < node.meshCount; j++)
+                    import.nodes[i].meshes.push_back(compiled->NodeMesh(node, j));
+            }
+            import.boundsMin = compiled->BoundsMin();
+            import.boundsMax = compiled->BoundsMax();
+            import.compiled = std::move(compiled);
+            return true;
+        }
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene;
+        {
+            LoadProfile::Timer timer(LoadProfile::READ_FILE);
+            scene = importer.ReadFile(path, importFlags);
+        }
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        vector<unsigned int> meshSources; // index into aiScene::mMeshes of every mesh, in node order
+        {
+            LoadProfile::Timer timer(LoadProfile::PROCESS_NODES);
+            processNode(scene->mRootNode, import.nodes, meshSources, -1);
+        }
+
+        // build the vertex and index arrays of all meshes in parallel
+        import.meshes.resize(meshSources.size());
+        {
+            LoadProfile::Timer timer(LoadProfile::PROCESS_MESHES);
+            ThreadPool::Shared().ParallelFor(meshSources.size(), [&](size_t i) {
+                import.meshes[i] = processMesh(scene->mMeshes[meshSources[i]]);
+            });
+        }
+
+        import.materials.resize(scene->mNumMaterials);
+        for(unsigned int i = 0; i < scene->mNumMaterials; i++)
+            import.materials[i] = materialTextures(scene->mMaterials[i]);
+        import.boundsMin = glm::vec3(meshSources.empty() ? 0.0f : INFINITY);
+        import.boundsMax = glm::vec3(meshSources.empty() ? 0.0f : -INFINITY);
+        for(unsigned int i = 0; i < meshSources.size(); i++)
+        {
+            import.meshMaterials.push_back(scene->mMeshes[meshSources[i]]->mMaterialIndex);
+            import.boundsMin = glm::min(import.boundsMin, import.meshes[i].boundsMin);
+            import.boundsMax = glm::max(import.boundsMax, import.meshes[i].boundsMax);
+            import.optimization.Add(import.meshes[i].optimization);
+        }
+        return true;
+    }
+
+    // GL phase, on the thread that owns the context. First the textures of every material in use and
+    // the model-wide data...
+    void beginUpload(ModelImport &import)
+    {
+        vector<bool> used(import.materials.size(), false);
+        for(unsigned int material : import.meshMaterials)
+            used[material] = true;
+        for(unsigned int i = 0; i < import.materials.size(); i++)
+            if (used[i])
+                for(Texture &texture : import.materials[i])
+                    texture.id = loadTexture(texture.path.c_str(), texture.type).id;
+        nodes = import.nodes;
+        boundsMin = import.boundsMin;
+        boundsMax = import.boundsMax;
+        optimization = import.optimization;
+        meshes.reserve(import.MeshCount());
+    }
+
+    // ...then each mesh in order...
+    void uploadMesh(ModelImport &import, unsigned int i)
+    {
+        LoadProfile::Timer timer(LoadProfile::MESH_UPLOAD);
+        const vector<Texture> &textures = import.materials[import.meshMaterials[i]];
+        if (import.compiled)
+        {
+            // straight from the mapped file
+            const CompiledModel &compiled = *import.compiled;
+            const CompiledModel::MeshRecord &mesh = compiled.MeshInfo(i);
+            vector<MeshLod> lods(compiled.Lods(i), compiled.Lods(i) + mesh.lodCount);
+            meshes.emplace_back(compiled.Vertices(i), mesh.vertexCount, compiled.Indices(i), mesh.indexCount, textures, vertexLayout,
+                                std::move(lods), cpuData);
+            return;
+        }
+        // the CPU copies stay until finishUpload has written the model cache
+        MeshData &data = import.meshes[i];
+        meshes.emplace_back(std::move(data.vertices), std::move(data.indices), textures, vertexLayout, std::move(data.lods));
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    // ...and finally compile a fresh import for the next run and drop what is no longer needed
+    void finishUpload(string const &path, ModelImport &import)
     {
+        if (!import.compiled)
+        {
+            LoadProfile::Timer timer(LoadProfile::CACHE_STORE);
+            ModelCache::Store(path, importFlags, meshes, import.meshMaterials, import.materials, nodes);
+            if (cpuData == CPU_DATA_RELEASE)
+                for(Mesh &mesh : meshes)
+                    mesh.ReleaseCpuData();
+        }
+        import = ModelImport();
+        groupMaterials();
+    }
+
+    // processes a node in a recursive fashion. Records the node and the meshes located at it and repeats this process on its children nodes (if any).
+    static void processNode(aiNode *node, vector<ModelNode> &nodes, vector<unsigned int> &meshSources, int parent)
+    {
+        int index = static_cast<int>(nodes.size());
+        nodes.push_back({ node->mName.C_Str(), parent, AssimpGLMHelpers::ConvertMatrixToGLMFormat(node->mTransformation), {} });
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            nodes[index].meshes.push_back(static_cast<unsigned int>(meshSources.size()));
+            meshSources.push_back(node->mMeshes[i]);
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], nodes, meshSources, index);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // extracts vertices, indices and bounds of a mesh; touches neither GL nor the model, so meshes can be processed concurrently
+    static MeshData processMesh(const aiMesh *mesh)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        MeshData data;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3); // faces are triangulated on import
+        data.boundsMin = glm::vec3(mesh->mNumVertices == 0 ? 0.0f : INFINITY);
+        data.boundsMax = glm::vec3(mesh->mNumVertices == 0 ? 0.0f : -INFINITY);
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex = {}; // zeroed, so unused attributes don't keep identical vertices from welding
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
             vector.y = mesh->mVertices[i].y;
             vector.z = mesh->mVertices[i].z;
             vertex.Position = vector;
+            data.boundsMin = glm::min(data.boundsMin, vector);
+            data.boundsMax = glm::max(data.boundsMax, vector);
             // normals
             if (mesh->HasNormals())
             {
@@ -139,68 +515,71 @@ private:
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);        
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
-        // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
-        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
-        // Same applies to other texture as the following list summarizes:
-        // diffuse: texture_diffuseN
-        // specular: texture_specularN
-        // normal: texture_normalN
+        // weld duplicates and reorder for the post-transform cache, overdraw and vertex fetch
+        MeshOptimizer::Optimize(vertices, indices, &data.optimization);
+        // coarser levels of detail over the same vertices
+        data.lods = MeshSimplifier::BuildLods(vertices, indices);
+        return data;
+    }
 
+    // lists the textures of a material (type and path; loading them is part of the GL phase).
+    // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
+    // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
+    // Same applies to other texture as the following list summarizes:
+    // diffuse: texture_diffuseN
+    // specular: texture_specularN
+    // normal: texture_normalN
+    static vector<Texture> materialTextures(const aiMaterial *material)
+    {
+        vector<Texture> textures;
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        materialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        materialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        materialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-        
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        materialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
+        return textures;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    static void materialTextures(const aiMaterial *mat, aiTextureType type, const string &typeName, vector<Texture> &textures)
     {
-        vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back({ 0, typeName, str.C_Str() });
         }
-        return textures;
+    }
+
+    // index into textures_loaded by path, so each distinct texture is acquired once per model
+    unordered_map<string, size_t> textureIndices;
+
+    // looks up a texture in the shared cache, which loads it unless another model already did
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        auto found = textureIndices.find(path);
+        if (found != textureIndices.end())
+        {
+            Texture texture = textures_loaded[found->second];
+            texture.type = typeName;
+            return texture;
+        }
+        Texture texture;
+        string file = this->directory + '/' + path;
+        texture.id = streamTextures ? TextureCache::Shared().AcquireStreamed(file, gammaCorrection)
+                                    : TextureCache::Shared().Acquire(file, gammaCorrection);
+        texture.type = typeName;
+        texture.path = path;
+        textureIndices.emplace(path, textures_loaded.size());
+        textures_loaded.push_back(texture);
+        return texture;
     }
 };
 
@@ -12,12 +12,14 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_cache.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <learnopengl/assimp_glm_helpers.h>
 #include <learnopengl/animdata.h>
@@ -28,19 +30,33 @@ class Model
 {
 public:
     // model data 
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Texture> textures_loaded;	// textures this model holds in the shared TextureCache, one per distinct path
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    VertexLayout vertexLayout;  // GPU vertex format of all meshes
+    CpuDataPolicy cpuData;      // whether meshes keep their vertices and indices after upload
 	
 	
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, VertexLayout layout = VERTEX_LAYOUT_FULL, CpuDataPolicy cpuData = CPU_DATA_RELEASE)
+        : gammaCorrection(gamma), vertexLayout(layout), cpuData(cpuData)
     {
         loadModel(path);
     }
 
+    // textures are reference counted in the shared cache, so a model is moved rather than copied
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&&) = default;
+
+    ~Model()
+    {
+        for (const Texture &texture : textures_loaded)
+            TextureCache::Shared().Release(texture.id);
+    }
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
@@ -55,6 +71,7 @@ public:
 private:
 
 	std::map<string, BoneInfo> m_BoneInfoMap;
+	unordered_map<string, size_t> textureIndices; // index into textures_loaded by path
 	int m_BoneCounter = 0;
 
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
@@ -73,6 +90,7 @@ private:
         directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
+        meshes.reserve(scene->mNumMeshes);
         processNode(scene->mRootNode, scene);
     }
 
@@ -85,7 +103,7 @@ private:
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            meshes.emplace_back(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
@@ -149,7 +167,7 @@ private:
 
 		ExtractBoneWeightForVertices(vertices,mesh,scene);
 
-		return Mesh(vertices, indices, textures);
+		return Mesh(std::move(vertices), std::move(indices), std::move(textures), vertexLayout, {}, cpuData);
 	}
 
 	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
@@ -252,26 +270,22 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            // each distinct path is acquired from the shared cache once per model
+            auto found = textureIndices.find(str.C_Str());
+            if(found != textureIndices.end())
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                Texture texture = textures_loaded[found->second];
                 texture.type = typeName;
-                texture.path = str.C_Str();
                 textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+                continue;
             }
+            Texture texture;
+            texture.id = TextureCache::Shared().Acquire(this->directory + '/' + str.C_Str(), gammaCorrection);
+            texture.type = typeName;
+            texture.path = str.C_Str();
+            textures.push_back(texture);
+            textureIndices.emplace(str.C_Str(), textures_loaded.size());
+            textures_loaded.push_back(texture);
         }
         return textures;
     }
@@ -0,0 +1,444 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// a node of a model's hierarchy; nodes are stored parents first
+struct ModelNode {
+    string name;
+    int parent;                   // index of the parent node, -1 for the root
+    glm::mat4 transform;          // relative to the parent
+    vector<unsigned int> meshes;  // indices into Model::meshes
+};
+
+// read-only, page-mapped view of a file
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const string& path)
+    {
+        Close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+            return Close(), false;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+            return Close(), false;
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED)
+            {
+                data = static_cast<const char*>(view);
+                size = static_cast<size_t>(info.st_size);
+            }
+        }
+        close(fd); // the mapping keeps the file alive
+#endif
+        return data != nullptr;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (data != nullptr)
+            UnmapViewOfFile(data);
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data != nullptr)
+            munmap(const_cast<char*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// A "compiled model" is everything Model extracts from an Assimp import, laid out so it can be used
+// in place: a header, fixed-size mesh/material/texture/node records, a string table, and then every
+// mesh's interleaved Vertex array and index array. Loading maps the file and hands the vertex and
+// index ranges to glBufferData directly, so a cache hit costs little more than the upload itself.
+class CompiledModel
+{
+public:
+    struct MeshRecord
+    {
+        uint32_t vertexCount, indexCount, material, firstLod, lodCount, padding;
+        uint64_t vertexOffset, indexOffset; // from the start of the file
+        glm::vec3 boundsMin, boundsMax;
+    };
+    struct MaterialRecord
+    {
+        uint32_t firstTexture, textureCount;
+    };
+    struct TextureRecord
+    {
+        uint32_t type, path; // offsets into the string table
+    };
+    struct NodeRecord
+    {
+        int32_t parent;
+        uint32_t name, firstMesh, meshCount; // meshes index the node mesh list
+        glm::mat4 transform;
+    };
+
+    bool Open(const string& path, uint64_t sourceSize, int64_t sourceTime);
+
+    unsigned int MeshCount() const { return header->meshCount; }
+    const MeshRecord& MeshInfo(unsigned int i) const { return meshRecords[i]; }
+    const Vertex* Vertices(unsigned int i) const { return reinterpret_cast<const Vertex*>(file.Data() + meshRecords[i].vertexOffset); }
+    const unsigned int* Indices(unsigned int i) const { return reinterpret_cast<const unsigned int*>(file.Data() + meshRecords[i].indexOffset); }
+    const MeshLod* Lods(unsigned int i) const { return lodRecords + meshRecords[i].firstLod; }
+
+    unsigned int MaterialCount() const { return header->materialCount; }
+    const MaterialRecord& Material(unsigned int i) const { return materialRecords[i]; }
+    const TextureRecord& MaterialTexture(unsigned int material, unsigned int j) const { return textureRecords[materialRecords[material].firstTexture + j]; }
+
+    unsigned int NodeCount() const { return header->nodeCount; }
+    const NodeRecord& Node(unsigned int i) const { return nodeRecords[i]; }
+    unsigned int NodeMesh(const NodeRecord& node, unsigned int j) const { return nodeMeshes[node.firstMesh + j]; }
+
+    const char* String(uint32_t offset) const { return strings + offset; }
+    glm::vec3 BoundsMin() const { return header->boundsMin; }
+    glm::vec3 BoundsMax() const { return header->boundsMax; }
+
+private:
+    friend class ModelCache;
+
+    static constexpr uint32_t MAGIC = 0x4D474F4C; // "LOGM"
+    static constexpr uint32_t VERSION = 3; // 2: meshes are optimized on import, 3: levels of detail
+
+    struct Header
+    {
+        uint32_t magic, version, vertexSize, importFlags;
+        uint64_t sourceSize;
+        int64_t  sourceTime;
+        uint32_t meshCount, lodCount, materialCount, textureCount, nodeCount, nodeMeshCount, stringsSize, padding;
+        glm::vec3 boundsMin, boundsMax;
+    };
+
+    MappedFile file;
+    const Header* header = nullptr;
+    const MeshRecord* meshRecords = nullptr;
+    const MeshLod* lodRecords = nullptr;
+    const MaterialRecord* materialRecords = nullptr;
+    const TextureRecord* textureRecords = nullptr;
+    const NodeRecord* nodeRecords = nullptr;
+    const uint32_t* nodeMeshes = nullptr;
+    const char* strings = nullptr;
+
+    // byte offsets of the tables following the header; every table starts 16-byte aligned
+    struct Layout
+    {
+        uint64_t meshes, lods, materials, textures, nodes, nodeMeshes, strings, end;
+    };
+    static uint64_t align(uint64_t offset) { return (offset + 15) & ~uint64_t(15); }
+    static Layout layout(const Header& h)
+    {
+        Layout l;
+        l.meshes = align(sizeof(Header));
+        l.lods = align(l.meshes + h.meshCount * sizeof(MeshRecord));
+        l.materials = align(l.lods + h.lodCount * sizeof(MeshLod));
+        l.textures = align(l.materials + h.materialCount * sizeof(MaterialRecord));
+        l.nodes = align(l.textures + h.textureCount * sizeof(TextureRecord));
+        l.nodeMeshes = align(l.nodes + h.nodeCount * sizeof(NodeRecord));
+        l.strings = align(l.nodeMeshes + h.nodeMeshCount * sizeof(uint32_t));
+        l.end = align(l.strings + h.stringsSize);
+        return l;
+    }
+};
+
+// Disk cache of compiled models. Entries are named after a hash of the source path and record the
+// source file's size and modification time, so an edited model is simply re-imported. The cache lives
+// in "model_cache/" next to the working directory; LOGL_MODEL_CACHE overrides the directory and an
+// empty value disables it. SetDirectory does the same from code.
+class ModelCache
+{
+public:
+    // overrides the cache directory; an empty one disables the cache. Call before loading any model.
+    static void SetDirectory(const string& dir)
+    {
+        directory() = dir;
+    }
+
+    // maps the compiled form of sourcePath if it is up to date and was imported with the same Assimp flags
+    static bool Open(const string& sourcePath, unsigned int importFlags, CompiledModel& compiled)
+    {
+        uint64_t size;
+        int64_t time;
+        if (directory().empty() || !sourceStamp(sourcePath, size, time))
+            return false;
+        if (!compiled.Open(entryPath(sourcePath), size, time) || compiled.header->importFlags != importFlags)
+            return false;
+        return true;
+    }
+
+    // writes the compiled form of an imported model; meshMaterials and materials index each other like
+    // Assimp's mMaterialIndex and mMaterials
+    static void Store(const string& sourcePath, unsigned int importFlags, const vector<Mesh>& meshes, const vector<unsigned int>& meshMaterials,
+                      const vector<vector<Texture>>& materials, const vector<ModelNode>& nodes)
+    {
+        CompiledModel::Header header = {};
+        if (directory().empty() || !sourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+            return;
+        header.magic = CompiledModel::MAGIC;
+        header.version = CompiledModel::VERSION;
+        header.vertexSize = sizeof(Vertex);
+        header.importFlags = importFlags;
+        header.meshCount = static_cast<uint32_t>(meshes.size());
+        header.materialCount = static_cast<uint32_t>(materials.size());
+        header.nodeCount = static_cast<uint32_t>(nodes.size());
+
+        string strings;
+        auto addString = [&strings](const string& s) {
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings.append(s.c_str(), s.size() + 1);
+            return offset;
+        };
+
+        vector<CompiledModel::MaterialRecord> materialRecords;
+        vector<CompiledModel::TextureRecord> textureRecords;
+        for (const vector<Texture>& material : materials)
+        {
+            materialRecords.push_back({ static_cast<uint32_t>(textureRecords.size()), static_cast<uint32_t>(material.size()) });
+            for (const Texture& texture : material)
+                textureRecords.push_back({ addString(texture.type), addString(texture.path) });
+        }
+        vector<CompiledModel::NodeRecord> nodeRecords;
+        vector<uint32_t> nodeMeshes;
+        for (const ModelNode& node : nodes)
+        {
+            nodeRecords.push_back({ node.parent, addString(node.name), static_cast<uint32_t>(nodeMeshes.size()), static_cast<uint32_t>(node.meshes.size()), node.transform });
+            nodeMeshes.insert(nodeMeshes.end(), node.meshes.begin(), node.meshes.end());
+        }
+        header.textureCount = static_cast<uint32_t>(textureRecords.size());
+        header.nodeMeshCount = static_cast<uint32_t>(nodeMeshes.size());
+        header.stringsSize = static_cast<uint32_t>(strings.size());
+
+        vector<MeshLod> lodRecords;
+        for (const Mesh& mesh : meshes)
+            lodRecords.insert(lodRecords.end(), mesh.lods.begin(), mesh.lods.end());
+        header.lodCount = static_cast<uint32_t>(lodRecords.size());
+
+        // mesh records point at the vertex/index arrays appended after the tables
+        CompiledModel::Layout layout = CompiledModel::layout(header);
+        vector<CompiledModel::MeshRecord> meshRecords(meshes.size());
+        uint32_t firstLod = 0;
+        uint64_t offset = layout.end;
+        header.boundsMin = glm::vec3(meshes.empty() ? 0.0f : INFINITY);
+        header.boundsMax = glm::vec3(meshes.empty() ? 0.0f : -INFINITY);
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            CompiledModel::MeshRecord& record = meshRecords[i];
+            record.vertexCount = static_cast<uint32_t>(meshes[i].vertices.size());
+            record.indexCount = static_cast<uint32_t>(meshes[i].indices.size());
+            record.material = i < meshMaterials.size() ? meshMaterials[i] : 0;
+            record.firstLod = firstLod;
+            record.lodCount = static_cast<uint32_t>(meshes[i].lods.size());
+            firstLod += record.lodCount;
+            record.vertexOffset = offset;
+            offset = CompiledModel::align(offset + record.vertexCount * sizeof(Vertex));
+            record.indexOffset = offset;
+            offset = CompiledModel::align(offset + record.indexCount * sizeof(unsigned int));
+            record.boundsMin = glm::vec3(record.vertexCount == 0 ? 0.0f : INFINITY);
+            record.boundsMax = glm::vec3(record.vertexCount == 0 ? 0.0f : -INFINITY);
+            for (const Vertex& vertex : meshes[i].vertices)
+            {
+                record.boundsMin = glm::min(record.boundsMin, vertex.Position);
+                record.boundsMax = glm::max(record.boundsMax, vertex.Position);
+            }
+            header.boundsMin = glm::min(header.boundsMin, record.boundsMin);
+            header.boundsMax = glm::max(header.boundsMax, record.boundsMax);
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory(), ec);
+        // write to a temporary file first so a crash never leaves a truncated entry behind
+        const string path = entryPath(sourcePath);
+        const string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            auto put = [&file](uint64_t at, const void* data, size_t bytes) {
+                static const char zeros[16] = {};
+                uint64_t position = static_cast<uint64_t>(file.tellp());
+                if (position < at)
+                    file.write(zeros, at - position);
+                if (bytes > 0)
+                    file.write(static_cast<const char*>(data), bytes);
+            };
+            put(0, &header, sizeof(header));
+            put(layout.meshes, meshRecords.data(), meshRecords.size() * sizeof(meshRecords[0]));
+            put(layout.lods, lodRecords.data(), lodRecords.size() * sizeof(MeshLod));
+            put(layout.materials, materialRecords.data(), materialRecords.size() * sizeof(materialRecords[0]));
+            put(layout.textures, textureRecords.data(), textureRecords.size() * sizeof(textureRecords[0]));
+            put(layout.nodes, nodeRecords.data(), nodeRecords.size() * sizeof(nodeRecords[0]));
+            put(layout.nodeMeshes, nodeMeshes.data(), nodeMeshes.size() * sizeof(uint32_t));
+            put(layout.strings, strings.data(), strings.size());
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                put(meshRecords[i].vertexOffset, meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex));
+                put(meshRecords[i].indexOffset, meshes[i].indices.data(), meshes[i].indices.size() * sizeof(unsigned int));
+            }
+            put(offset, nullptr, 0);
+            if (!file)
+            {
+                std::cout << "ERROR::MODEL_CACHE: failed to write " << temp << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+            std::filesystem::remove(temp, ec);
+    }
+
+private:
+    static string& directory()
+    {
+        static char const * envDir = getenv("LOGL_MODEL_CACHE");
+        static string dir = envDir != nullptr ? envDir : "model_cache";
+        return dir;
+    }
+
+    static string entryPath(const string& sourcePath)
+    {
+        std::error_code ec;
+        string canonical = std::filesystem::weakly_canonical(sourcePath, ec).generic_string();
+        if (ec)
+            canonical = sourcePath;
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (unsigned char c : canonical)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.logm", static_cast<unsigned long long>(hash));
+        return directory() + "/" + name;
+    }
+
+    static bool sourceStamp(const string& sourcePath, uint64_t& size, int64_t& time)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(sourcePath, ec);
+        if (ec)
+            return false;
+        time = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+        return !ec;
+    }
+};
+
+inline bool CompiledModel::Open(const string& path, uint64_t sourceSize, int64_t sourceTime)
+{
+    if (!file.Open(path) || file.Size() < sizeof(Header))
+        return false;
+    header = reinterpret_cast<const Header*>(file.Data());
+    if (header->magic != MAGIC || header->version != VERSION || header->vertexSize != sizeof(Vertex)
+        || header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+        return false;
+    Layout l = layout(*header);
+    if (file.Size() < l.end)
+        return false;
+    meshRecords = reinterpret_cast<const MeshRecord*>(file.Data() + l.meshes);
+    lodRecords = reinterpret_cast<const MeshLod*>(file.Data() + l.lods);
+    materialRecords = reinterpret_cast<const MaterialRecord*>(file.Data() + l.materials);
+    textureRecords = reinterpret_cast<const TextureRecord*>(file.Data() + l.textures);
+    nodeRecords = reinterpret_cast<const NodeRecord*>(file.Data() + l.nodes);
+    nodeMeshes = reinterpret_cast<const uint32_t*>(file.Data() + l.nodeMeshes);
+    strings = file.Data() + l.strings;
+    // a truncated or corrupt file must not hand out ranges past its end, nor indices past the records
+    for (unsigned int i = 0; i < header->meshCount; ++i)
+    {
+        const MeshRecord& mesh = meshRecords[i];
+        if (mesh.vertexOffset + uint64_t(mesh.vertexCount) * sizeof(Vertex) > file.Size()
+            || mesh.indexOffset + uint64_t(mesh.indexCount) * sizeof(unsigned int) > file.Size()
+            || mesh.lodCount == 0 || uint64_t(mesh.firstLod) + mesh.lodCount > header->lodCount
+            || mesh.material >= header->materialCount)
+            return false;
+        for (unsigned int j = 0; j < mesh.lodCount; ++j)
+        {
+            const MeshLod& lod = lodRecords[mesh.firstLod + j];
+            if (uint64_t(lod.indexOffset) + lod.indexCount > mesh.indexCount)
+                return false;
+        }
+    }
+    // strings are offsets into the table and must end inside it
+    if (header->stringsSize > 0 && strings[header->stringsSize - 1] != '\0')
+        return false;
+    for (unsigned int i = 0; i < header->materialCount; ++i)
+        if (uint64_t(materialRecords[i].firstTexture) + materialRecords[i].textureCount > header->textureCount)
+            return false;
+    for (unsigned int i = 0; i < header->textureCount; ++i)
+        if (textureRecords[i].type >= header->stringsSize || textureRecords[i].path >= header->stringsSize)
+            return false;
+    for (unsigned int i = 0; i < header->nodeCount; ++i)
+    {
+        const NodeRecord& node = nodeRecords[i];
+        if (node.parent >= static_cast<int64_t>(i) || node.parent < -1 || node.name >= header->stringsSize
+            || uint64_t(node.firstMesh) + node.meshCount > header->nodeMeshCount)
+            return false;
+    }
+    for (unsigned int i = 0; i < header->nodeMeshCount; ++i)
+        if (nodeMeshes[i] >= header->meshCount)
+            return false;
+    return true;
+}
+#endif
@@ -0,0 +1,171 @@
+#ifndef MODEL_STREAMER_H
+#define MODEL_STREAMER_H
+
+#include <learnopengl/model.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/thread_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A model on its way in through ModelStreamer. The handle exists from the moment Load returns; the
+// model itself becomes drawable once its geometry is uploaded, with placeholder textures that
+// sharpen while the images stream in.
+class StreamedModel
+{
+public:
+    enum State {
+        IMPORTING,      // reading the model cache entry or the file on a worker thread
+        UPLOADING,      // meshes are uploaded a few per frame
+        STREAMING,      // drawable; textures are still coming in
+        READY,          // everything resident at full quality
+        FAILED
+    };
+
+    // called from ModelStreamer::Update, on the thread that owns the context
+    std::function<void(StreamedModel&)> OnProgress;
+    std::function<void(StreamedModel&)> OnReady;
+
+    State GetState() const { return state; }
+    bool Drawable() const { return state == STREAMING || state == READY; }
+    const string& Path() const { return path; }
+
+    // fraction of meshes and textures that are fully resident
+    float Progress() const { return progress; }
+
+    // the model, or nullptr until it is drawable
+    Model* Get() { return Drawable() ? model.get() : nullptr; }
+
+private:
+    friend class ModelStreamer;
+
+    string path;
+    State state = IMPORTING;
+    float progress = 0.0f;
+    unique_ptr<Model> model;
+    ModelImport import;
+    std::atomic<bool> imported{ false };
+    bool importSucceeded = false;
+    unsigned int nextMesh = 0;
+};
+
+// Loads models without stalling the render loop. Load returns a handle at once and reads the file on
+// a worker thread; Update, called once per frame, spends at most a given number of milliseconds on
+// GL uploads: geometry first, a mesh at a time, then the mip levels of the textures from the
+// smallest up. Time to first frame is what matters, so a model is drawable as soon as its meshes are.
+class ModelStreamer
+{
+public:
+    std::shared_ptr<StreamedModel> Load(string const &path, bool gamma = false, VertexLayout layout = VERTEX_LAYOUT_FULL,
+                                        CpuDataPolicy cpuData = CPU_DATA_RELEASE)
+    {
+        auto handle = std::make_shared<StreamedModel>();
+        handle->path = path;
+        handle->model.reset(new Model(Model::StreamTag(), path, gamma, layout, cpuData));
+        ThreadPool::Shared().Submit([handle] {
+            // nobody waits on the job's future, so an exception would be lost there and leave the
+            // handle importing forever; it fails the handle instead
+            try
+            {
+                handle->importSucceeded = Model::importModel(handle->path, handle->import);
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "ERROR::MODEL_STREAMER: importing " << handle->path << " failed: " << e.what() << std::endl;
+                handle->importSucceeded = false;
+            }
+            catch (...)
+            {
+                std::cout << "ERROR::MODEL_STREAMER: importing " << handle->path << " failed" << std::endl;
+                handle->importSucceeded = false;
+            }
+            handle->imported.store(true, std::memory_order_release);
+        });
+        active.push_back(handle);
+        return handle;
+    }
+
+    // performs pending uploads for about budgetMs milliseconds; at least one step is taken per call so
+    // loading always advances. Returns whether anything is still loading.
+    bool Update(float budgetMs)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::microseconds(static_cast<long long>(budgetMs * 1000.0f));
+        bool first = true;
+        for (const std::shared_ptr<StreamedModel> &handle : active)
+        {
+            StreamedModel &streamed = *handle;
+            if (streamed.state == StreamedModel::IMPORTING && streamed.imported.load(std::memory_order_acquire))
+            {
+                if (!streamed.importSucceeded)
+                {
+                    streamed.state = StreamedModel::FAILED;
+                    continue;
+                }
+                streamed.model->beginUpload(streamed.import);
+                streamed.state = StreamedModel::UPLOADING;
+            }
+            while (streamed.state == StreamedModel::UPLOADING && (first || std::chrono::steady_clock::now() < deadline))
+            {
+                first = false;
+                if (streamed.nextMesh < streamed.import.MeshCount())
+                    streamed.model->uploadMesh(streamed.import, streamed.nextMesh++);
+                if (streamed.nextMesh == streamed.import.MeshCount())
+                {
+                    streamed.model->finishUpload(streamed.path, streamed.import);
+                    streamed.state = StreamedModel::STREAMING;
+                }
+            }
+        }
+        TextureCache::Shared().StreamUploads(deadline);
+
+        // progress, readiness, and handles that are done
+        for (size_t i = 0; i < active.size(); )
+        {
+            std::shared_ptr<StreamedModel> handle = active[i];
+            float progress = measure(*handle);
+            if (progress != handle->progress)
+            {
+                handle->progress = progress;
+                if (handle->OnProgress)
+                    handle->OnProgress(*handle);
+            }
+            if (handle->state == StreamedModel::STREAMING && progress == 1.0f)
+            {
+                handle->state = StreamedModel::READY;
+                if (handle->OnReady)
+                    handle->OnReady(*handle);
+            }
+            if (handle->state == StreamedModel::READY || handle->state == StreamedModel::FAILED)
+                active.erase(active.begin() + i);
+            else
+                i++;
+        }
+        return !active.empty();
+    }
+
+    bool Idle() const { return active.empty(); }
+
+private:
+    std::vector<std::shared_ptr<StreamedModel>> active;
+
+    static float measure(const StreamedModel &streamed)
+    {
+        if (streamed.state == StreamedModel::IMPORTING || streamed.state == StreamedModel::FAILED)
+            return 0.0f;
+        const Model &model = *streamed.model;
+        size_t meshes = streamed.state == StreamedModel::UPLOADING ? streamed.import.MeshCount() : model.meshes.size();
+        size_t total = meshes + model.textures_loaded.size(), done = model.meshes.size();
+        for (const Texture &texture : model.textures_loaded)
+            if (!TextureCache::Shared().IsStreaming(texture.id))
+                done++;
+        return total == 0 ? 1.0f : static_cast<float>(done) / total;
+    }
+};
+#endif
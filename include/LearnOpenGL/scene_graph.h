@@ -0,0 +1,297 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/euler_angles.hpp>
+
+#include <learnopengl/frustum.h>
+#include <learnopengl/frustum_culler.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Flat alternative to the Entity tree for large scenes. Nodes live in parallel arrays ordered by
+// depth in the hierarchy, so every parent comes before its children and updating the world transforms
+// is one forward sweep: a node is recomputed when it or an ancestor changed since the last Update, and
+// untouched subtrees cost a flag test per node. Nodes are referred to by a NodeId that stays valid
+// when the arrays are reordered.
+//
+//     SceneGraph scene;
+//     SceneGraph::NodeId planet = scene.AddNode(SceneGraph::INVALID_NODE, &planetModel);
+//     SceneGraph::NodeId moon = scene.AddNode(planet, &moonModel);
+//     scene.SetLocalPosition(moon, glm::vec3(10.0f, 0.0f, 0.0f));
+//     scene.Update();
+//     scene.DrawInstanced(frustum, shader, display, total);
+class SceneGraph
+{
+public:
+    typedef unsigned int NodeId;
+    static const NodeId INVALID_NODE = ~0u;
+
+    SceneGraph() = default;
+    ~SceneGraph()
+    {
+        if (instanceBuffer)
+            glDeleteBuffers(1, &instanceBuffer);
+    }
+    SceneGraph(const SceneGraph&) = delete;
+    SceneGraph& operator=(const SceneGraph&) = delete;
+
+    // adds a node under parent (INVALID_NODE for a root) drawing model, which may be null for a pure
+    // transform node; the node's bounds are the model's
+    NodeId AddNode(NodeId parent = INVALID_NODE, Model* model = nullptr)
+    {
+        int parentIndex = parent == INVALID_NODE ? -1 : static_cast<int>(indexOf[parent]);
+        unsigned int depth = parentIndex < 0 ? 0 : depths[parentIndex] + 1;
+        // appending keeps the arrays sorted unless the new node is shallower than the last one
+        if (!depths.empty() && depth < depths.back())
+            unsorted = true;
+
+        NodeId id = static_cast<NodeId>(indexOf.size());
+        indexOf.push_back(static_cast<unsigned int>(ids.size()));
+        ids.push_back(id);
+        parents.push_back(parentIndex);
+        depths.push_back(depth);
+        positions.push_back(glm::vec3(0.0f));
+        rotations.push_back(glm::vec3(0.0f));
+        scales.push_back(glm::vec3(1.0f));
+        worlds.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+        models.push_back(model);
+        localCenters.push_back(model ? (model->boundsMin + model->boundsMax) * 0.5f : glm::vec3(0.0f));
+        localExtents.push_back(model ? (model->boundsMax - model->boundsMin) * 0.5f : glm::vec3(0.0f));
+        for (std::vector<float>* bound : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+            bound->push_back(0.0f);
+        return id;
+    }
+
+    size_t Count() const { return ids.size(); }
+
+    void SetLocalPosition(NodeId node, const glm::vec3& position) { positions[indexOf[node]] = position; dirty[indexOf[node]] = 1; }
+    // Euler angles in degrees, applied like Transform's: Y * X * Z
+    void SetLocalRotation(NodeId node, const glm::vec3& rotation) { rotations[indexOf[node]] = rotation; dirty[indexOf[node]] = 1; }
+    void SetLocalScale(NodeId node, const glm::vec3& scale) { scales[indexOf[node]] = scale; dirty[indexOf[node]] = 1; }
+
+    // overrides the model's bounds, in the node's local space
+    void SetLocalBounds(NodeId node, const glm::vec3& min, const glm::vec3& max)
+    {
+        unsigned int index = indexOf[node];
+        localCenters[index] = (min + max) * 0.5f;
+        localExtents[index] = (max - min) * 0.5f;
+        dirty[index] = 1;
+    }
+
+    const glm::vec3& GetLocalPosition(NodeId node) const { return positions[indexOf[node]]; }
+    const glm::vec3& GetLocalRotation(NodeId node) const { return rotations[indexOf[node]]; }
+    const glm::vec3& GetLocalScale(NodeId node) const { return scales[indexOf[node]]; }
+    // valid after Update
+    const glm::mat4& GetWorldMatrix(NodeId node) const { return worlds[indexOf[node]]; }
+
+    NodeId GetParent(NodeId node) const
+    {
+        int parent = parents[indexOf[node]];
+        return parent < 0 ? INVALID_NODE : ids[parent];
+    }
+
+    // the node at an index returned by Cull
+    NodeId GetNode(unsigned int index) const { return ids[index]; }
+
+    // recomputes the world transform and bounds of every node that changed or whose ancestor changed,
+    // and returns how many that were
+    unsigned int Update()
+    {
+        if (unsorted)
+            sortByDepth();
+        unsigned int recomputed = 0;
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            int parent = parents[i];
+            // the parent was visited first, so its flag already includes its own ancestors
+            if (parent >= 0 && dirty[parent])
+                dirty[i] = 1;
+            if (!dirty[i])
+                continue;
+            glm::mat4 local = localMatrix(positions[i], rotations[i], scales[i]);
+            worlds[i] = parent < 0 ? local : worlds[parent] * local;
+            worldBounds(i);
+            recomputed++;
+        }
+        // flags are cleared only after the sweep: children read their parent's
+        std::fill(dirty.begin(), dirty.end(), 0);
+        return recomputed;
+    }
+
+    // fills visible with the nodes that have a model and whose bounds touch the frustum, as indices
+    // into the node arrays that stay valid until the next AddNode or Update. Returns their count.
+    size_t Cull(const Frustum& frustum, std::vector<unsigned int>& visible) const
+    {
+        FrustumCuller(frustum).Cull(centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data(),
+                                    ids.size(), visible);
+        // transform only nodes have no bounds to speak of
+        visible.erase(std::remove_if(visible.begin(), visible.end(), [this](unsigned int i) { return !models[i]; }), visible.end());
+        return visible.size();
+    }
+
+    // world matrices of the visible nodes drawing model, in one array for an instance buffer
+    void GatherInstances(const std::vector<unsigned int>& visible, const Model* model, std::vector<glm::mat4>& matrices) const
+    {
+        matrices.clear();
+        for (unsigned int i : visible)
+            if (models[i] == model)
+                matrices.push_back(worlds[i]);
+    }
+
+    // draws every node with a model whose bounds touch the frustum, one Model::Draw per node with the
+    // world matrix in the shader's "model" uniform
+    void Draw(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& total)
+    {
+        total += static_cast<unsigned int>(ids.size() - std::count(models.begin(), models.end(), nullptr));
+        Cull(frustum, visibleScratch);
+        for (unsigned int i : visibleScratch)
+        {
+            shader.setMat4("model", worlds[i]);
+            models[i]->Draw(shader);
+            display++;
+        }
+    }
+
+    // draws the same nodes as Draw, but buckets them by model and issues one instanced draw per mesh
+    // of each model. The shader reads the world matrix from the instance attributes (see
+    // Mesh::DrawInstanced) instead of a "model" uniform:
+    //     layout (location = 7) in mat4 aInstanceMatrix;
+    void DrawInstanced(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& total)
+    {
+        total += static_cast<unsigned int>(ids.size() - std::count(models.begin(), models.end(), nullptr));
+        Cull(frustum, visibleScratch);
+        // the models in view, in the order they are first seen; scenes have few distinct models
+        modelScratch.clear();
+        for (unsigned int i : visibleScratch)
+            if (std::find(modelScratch.begin(), modelScratch.end(), models[i]) == modelScratch.end())
+                modelScratch.push_back(models[i]);
+
+        // every model's matrices back to back in one buffer, refilled each call
+        instanceScratch.clear();
+        firstScratch.clear();
+        for (Model* model : modelScratch)
+        {
+            GatherInstances(visibleScratch, model, bucketScratch);
+            firstScratch.push_back(instanceScratch.size());
+            instanceScratch.insert(instanceScratch.end(), bucketScratch.begin(), bucketScratch.end());
+        }
+        firstScratch.push_back(instanceScratch.size());
+        if (instanceScratch.empty())
+            return;
+        if (!instanceBuffer)
+            glGenBuffers(1, &instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, instanceScratch.size() * sizeof(glm::mat4), instanceScratch.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        for (size_t m = 0; m < modelScratch.size(); m++)
+        {
+            GLsizei count = static_cast<GLsizei>(firstScratch[m + 1] - firstScratch[m]);
+            modelScratch[m]->DrawInstanced(shader, instanceBuffer, firstScratch[m] * sizeof(glm::mat4), count);
+            display += static_cast<unsigned int>(count);
+        }
+    }
+
+private:
+    // per node, in depth order
+    std::vector<NodeId> ids;
+    std::vector<int> parents; // index of the parent, -1 for roots
+    std::vector<unsigned int> depths;
+    std::vector<glm::vec3> positions, rotations, scales;
+    std::vector<glm::mat4> worlds;
+    std::vector<unsigned char> dirty;
+    std::vector<Model*> models;
+    std::vector<glm::vec3> localCenters, localExtents;
+    // world space bounds, one array per component
+    std::vector<float> centerX, centerY, centerZ, extentX, extentY, extentZ;
+
+    std::vector<unsigned int> indexOf; // per NodeId, its index in the arrays above
+    std::vector<unsigned int> visibleScratch;
+    // DrawInstanced: the models in view, their matrices and where each model's range starts
+    std::vector<Model*> modelScratch;
+    std::vector<glm::mat4> instanceScratch, bucketScratch;
+    std::vector<size_t> firstScratch;
+    unsigned int instanceBuffer = 0;
+    bool unsorted = false;
+
+    static glm::mat4 localMatrix(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
+    {
+        glm::mat4 m = glm::eulerAngleYXZ(glm::radians(rotation.y), glm::radians(rotation.x), glm::radians(rotation.z));
+        m[0] *= scale.x;
+        m[1] *= scale.y;
+        m[2] *= scale.z;
+        m[3] = glm::vec4(position, 1.0f);
+        return m;
+    }
+
+    // the world axis aligned box around the transformed local box, as AABB::isOnFrustum computes it
+    void worldBounds(size_t i)
+    {
+        const glm::mat4& m = worlds[i];
+        glm::vec3 center = glm::vec3(m * glm::vec4(localCenters[i], 1.0f));
+        glm::vec3 extent = glm::abs(glm::vec3(m[0])) * localExtents[i].x + glm::abs(glm::vec3(m[1])) * localExtents[i].y +
+                           glm::abs(glm::vec3(m[2])) * localExtents[i].z;
+        centerX[i] = center.x; centerY[i] = center.y; centerZ[i] = center.z;
+        extentX[i] = extent.x; extentY[i] = extent.y; extentZ[i] = extent.z;
+    }
+
+    template<typename T>
+    static void permute(std::vector<T>& values, const std::vector<unsigned int>& order)
+    {
+        std::vector<T> sorted;
+        sorted.reserve(values.size());
+        for (unsigned int from : order)
+            sorted.push_back(values[from]);
+        values.swap(sorted);
+    }
+
+    // stable counting sort on depth; parents stay ahead of their children
+    void sortByDepth()
+    {
+        unsigned int maxDepth = 0;
+        for (unsigned int depth : depths)
+            maxDepth = std::max(maxDepth, depth);
+        std::vector<unsigned int> first(maxDepth + 2, 0);
+        for (unsigned int depth : depths)
+            first[depth + 1]++;
+        for (size_t d = 1; d < first.size(); d++)
+            first[d] += first[d - 1];
+        std::vector<unsigned int> order(ids.size());
+        for (unsigned int i = 0; i < ids.size(); i++)
+            order[first[depths[i]]++] = i;
+
+        std::vector<unsigned int> newIndex(ids.size());
+        for (unsigned int i = 0; i < order.size(); i++)
+            newIndex[order[i]] = i;
+        for (int& parent : parents)
+            if (parent >= 0)
+                parent = static_cast<int>(newIndex[parent]);
+
+        permute(ids, order);
+        permute(parents, order);
+        permute(depths, order);
+        permute(positions, order);
+        permute(rotations, order);
+        permute(scales, order);
+        permute(worlds, order);
+        permute(dirty, order);
+        permute(models, order);
+        permute(localCenters, order);
+        permute(localExtents, order);
+        for (std::vector<float>* bound : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+            permute(*bound, order);
+        for (unsigned int i = 0; i < ids.size(); i++)
+            indexOf[ids[i]] = i;
+        unsorted = false;
+    }
+};
+#endif
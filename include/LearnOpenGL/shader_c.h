@@ -9,6 +9,8 @@
 #include <sstream>
 #include <iostream>
 
+#include <learnopengl/shader_cache.h>
+
 class ComputeShader
 {
 public:
@@ -40,7 +42,12 @@ public:
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
         }
         const char* cShaderCode = computeCode.c_str();
-        // 2. compile shaders
+        // 2. reuse a cached program binary when one matches these sources
+        std::string cacheKey = ShaderCache::MakeKey({ cShaderCode });
+        ID = ShaderCache::Load(cacheKey);
+        if (ID != 0)
+            return;
+        // 3. compile shaders
         unsigned int compute;
         // compute shader
         compute = glCreateShader(GL_COMPUTE_SHADER);
@@ -50,9 +57,11 @@ public:
         
         // shader Program
         ID = glCreateProgram();
+        ShaderCache::Prepare(ID);
         glAttachShader(ID, compute);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        ShaderCache::Store(ID, cacheKey);
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(compute);
     }
@@ -0,0 +1,172 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <initializer_list>
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Entries are keyed on a hash
+// of the concatenated shader sources together with the driver's vendor, renderer and version
+// strings, so a driver update or a shader edit simply misses the cache. The cache lives in
+// "shader_cache/" next to the working directory; LOGL_SHADER_CACHE overrides the directory
+// and an empty value disables the cache altogether.
+class ShaderCache
+{
+public:
+    // builds the cache key for a program made of the given stage sources (nullptr for absent stages)
+    static std::string MakeKey(std::initializer_list<const char*> sources)
+    {
+        return MakeKey(std::vector<const char*>(sources));
+    }
+    static std::string MakeKey(const std::vector<const char*>& sources)
+    {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a offset basis
+        for (const char* source : sources)
+        {
+            hashBytes(hash, source != nullptr ? source : "");
+            hashBytes(hash, "\x1f"); // stage separator, so moving code between stages changes the key
+        }
+        hashBytes(hash, glString(GL_VENDOR));
+        hashBytes(hash, glString(GL_RENDERER));
+        hashBytes(hash, glString(GL_VERSION));
+
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+        return key;
+    }
+
+    // creates a program from a cached binary; returns 0 on a miss or when the driver rejects the binary
+    static unsigned int Load(const std::string& key)
+    {
+        if (!enabled())
+            return 0;
+        std::ifstream file(entryPath(key), std::ios::binary);
+        if (!file)
+            return 0;
+
+        Header header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != MAGIC || header.size == 0)
+            return 0;
+        std::vector<char> binary(header.size);
+        file.read(binary.data(), header.size);
+        if (!file)
+            return 0;
+
+        unsigned int program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            // stale or foreign binary: drop it and let the caller compile from source
+            glDeleteProgram(program);
+            std::error_code ec;
+            std::filesystem::remove(entryPath(key), ec);
+            return 0;
+        }
+        return program;
+    }
+
+    // must be called between glCreateProgram and glLinkProgram so the driver keeps a retrievable binary
+    static void Prepare(unsigned int program)
+    {
+        if (enabled())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // stores the binary of a successfully linked program under the given key
+    static void Store(unsigned int program, const std::string& key)
+    {
+        if (!enabled())
+            return;
+        int success, length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!success || length <= 0)
+            return;
+
+        Header header;
+        std::vector<char> binary(length);
+        glGetProgramBinary(program, length, nullptr, &header.format, binary.data());
+        header.size = static_cast<uint32_t>(length);
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory(), ec);
+        // write to a temporary file first so a crash never leaves a truncated entry behind
+        const std::string path = entryPath(key);
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), binary.size());
+            if (!file)
+            {
+                std::cout << "ERROR::SHADER_CACHE: failed to write " << temp << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+            std::filesystem::remove(temp, ec);
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x42504C47; // "GLPB"
+
+    struct Header
+    {
+        uint32_t magic = MAGIC;
+        GLenum   format = 0;
+        uint32_t size = 0;
+    };
+
+    static void hashBytes(uint64_t& hash, const char* bytes)
+    {
+        for (; *bytes; ++bytes)
+        {
+            hash ^= static_cast<unsigned char>(*bytes);
+            hash *= 1099511628211ull; // FNV-1a prime
+        }
+    }
+
+    static const char* glString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    static const std::string& directory()
+    {
+        static char const * envDir = getenv("LOGL_SHADER_CACHE");
+        static std::string dir = envDir != nullptr ? envDir : "shader_cache";
+        return dir;
+    }
+
+    static std::string entryPath(const std::string& key)
+    {
+        return directory() + "/" + key + ".bin";
+    }
+
+    // the cache needs a directory and a driver that exposes at least one program binary format
+    static bool enabled()
+    {
+        static bool supported = [] {
+            if (directory().empty() || glGetProgramBinary == nullptr || glProgramBinary == nullptr)
+                return false;
+            int formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            return formats > 0;
+        }();
+        return supported;
+    }
+};
+#endif
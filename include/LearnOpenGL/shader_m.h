@@ -9,6 +9,8 @@
 #include <sstream>
 #include <iostream>
 
+#include <learnopengl/shader_cache.h>
+
 class Shader
 {
 public:
@@ -47,7 +49,12 @@ public:
         }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 2. reuse a cached program binary when one matches these sources
+        std::string cacheKey = ShaderCache::MakeKey({ vShaderCode, fShaderCode });
+        ID = ShaderCache::Load(cacheKey);
+        if (ID != 0)
+            return;
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -61,10 +68,12 @@ public:
         checkCompileErrors(fragment, "FRAGMENT");
         // shader Program
         ID = glCreateProgram();
+        ShaderCache::Prepare(ID);
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        ShaderCache::Store(ID, cacheKey);
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -0,0 +1,437 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <learnopengl/material.h>
+#include <learnopengl/shader_cache.h>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Watches the source files of registered shader programs and rebuilds them when they change on disk.
+// A background thread notices the change (inotify on Linux, modification-time polling elsewhere) and
+// reads the new sources; Update(), called once per frame on the GL thread, submits the compile and
+// later swaps the program ID in place. With GL_KHR_parallel_shader_compile the link is polled
+// through GL_COMPLETION_STATUS_KHR, so the frame never waits on the compiler. A program is only
+// replaced once it links; on failure the error log is printed and the old program keeps running.
+// Uniform values of the old program (samplers, projection matrices, kernels...) are copied over.
+class ShaderWatcher
+{
+public:
+    struct Stage
+    {
+        GLenum type; // GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, ...
+        std::string path;
+    };
+
+    ShaderWatcher() = default;
+    ~ShaderWatcher() { Stop(); }
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // registers a program for hot-reload; *program is overwritten with the new ID after a successful rebuild
+    void Watch(unsigned int* program, const std::vector<Stage>& stages)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry entry;
+        entry.program = program;
+        for (const Stage& stage : stages)
+        {
+            Stage normalized = { stage.type, normalize(stage.path) };
+            entry.stages.push_back(normalized);
+            entry.stamps.push_back(lastWriteTime(normalized.path));
+            addDirectory(std::filesystem::path(normalized.path).parent_path().string());
+        }
+        entries.push_back(entry);
+        if (!running)
+            start();
+    }
+
+    // drives pending rebuilds; call once per frame with the context current
+    void Update()
+    {
+        std::vector<Request> requests;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.swap(queued);
+        }
+        for (Request& request : requests)
+            submit(request);
+
+        for (size_t i = 0; i < building.size();)
+        {
+            if (!isComplete(building[i].program))
+            {
+                ++i;
+                continue;
+            }
+            finish(building[i]);
+            building.erase(building.begin() + i);
+        }
+    }
+
+    // stops the watcher thread; already swapped programs stay valid
+    void Stop()
+    {
+        if (!running)
+            return;
+        running = false;
+        if (worker.joinable())
+            worker.join();
+#ifdef __linux__
+        if (inotifyFd >= 0)
+            close(inotifyFd);
+        inotifyFd = -1;
+#endif
+    }
+
+private:
+    struct Entry
+    {
+        unsigned int* program;
+        std::vector<Stage> stages;
+        std::vector<std::filesystem::file_time_type> stamps;
+    };
+    // sources read by the watcher thread, waiting to be handed to the driver
+    struct Request
+    {
+        size_t entry;
+        std::vector<std::string> sources;
+    };
+    // a program that has been submitted to the driver but not swapped in yet
+    struct Build
+    {
+        size_t entry;
+        unsigned int program;
+        std::vector<unsigned int> shaders;
+        std::string cacheKey;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Request> queued;
+    std::vector<Build> building;
+    std::vector<std::string> directories;
+    std::mutex mutex;
+    std::thread worker;
+    std::atomic<bool> running{ false };
+#ifdef __linux__
+    int inotifyFd = -1;
+#endif
+
+    static std::string normalize(const std::string& path)
+    {
+        std::error_code ec;
+        std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+        return (ec ? std::filesystem::path(path) : absolute).lexically_normal().string();
+    }
+
+    static std::filesystem::file_time_type lastWriteTime(const std::string& path)
+    {
+        std::error_code ec;
+        auto stamp = std::filesystem::last_write_time(path, ec);
+        return ec ? std::filesystem::file_time_type::min() : stamp;
+    }
+
+    void addDirectory(const std::string& directory)
+    {
+        for (const std::string& known : directories)
+            if (known == directory)
+                return;
+        directories.push_back(directory);
+#ifdef __linux__
+        if (inotifyFd < 0)
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        // editors either rewrite the file in place or move a temporary over it
+        if (inotifyFd >= 0 && inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+            std::cout << "WARNING::SHADER_WATCHER: cannot watch " << directory << std::endl;
+#endif
+    }
+
+    void start()
+    {
+        running = true;
+        worker = std::thread([this] { watch(); });
+    }
+
+    // watcher thread: waits for file changes and queues the affected programs
+    void watch()
+    {
+        while (running)
+        {
+#ifdef __linux__
+            if (inotifyFd >= 0)
+            {
+                pollfd pfd = { inotifyFd, POLLIN, 0 };
+                if (poll(&pfd, 1, 200) <= 0)
+                    continue;
+                // a short grace period collapses the burst of events a single save produces
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                // drain the events; comparing the timestamps of the registered files afterwards is
+                // simpler than mapping watch descriptors and names back to programs
+                alignas(inotify_event) char buffer[4096];
+                while (read(inotifyFd, buffer, sizeof(buffer)) > 0)
+                    ;
+            }
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(250));
+#else
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+#endif
+            scan();
+        }
+    }
+
+    void scan()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            Entry& entry = entries[i];
+            std::vector<std::filesystem::file_time_type> stamps;
+            bool changed = false;
+            for (size_t s = 0; s < entry.stages.size(); ++s)
+            {
+                stamps.push_back(lastWriteTime(entry.stages[s].path));
+                changed = changed || stamps[s] != entry.stamps[s];
+            }
+            if (!changed)
+                continue;
+
+            Request request;
+            request.entry = i;
+            bool readable = true;
+            for (const Stage& stage : entry.stages)
+            {
+                std::ifstream file(stage.path);
+                std::stringstream stream;
+                stream << file.rdbuf();
+                readable = readable && file.good();
+                request.sources.push_back(stream.str());
+            }
+            // caught mid-write: the stamps are left alone so the next scan reads the files again
+            if (!readable)
+                continue;
+            entry.stamps = stamps;
+            // a newer edit replaces a rebuild that has not been submitted yet
+            bool replaced = false;
+            for (Request& pending : queued)
+            {
+                if (pending.entry == i)
+                {
+                    pending.sources = request.sources;
+                    replaced = true;
+                }
+            }
+            if (!replaced)
+                queued.push_back(request);
+        }
+    }
+
+    static bool parallelCompile()
+    {
+        static bool supported = [] {
+            int count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (int i = 0; i < count; ++i)
+            {
+                const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (name != nullptr && (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 ||
+                                        std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+                    return true;
+            }
+            return false;
+        }();
+        return supported;
+    }
+
+    // compiles and links without querying any status, so the driver is free to work in the background
+    void submit(const Request& request)
+    {
+        const Entry& entry = entries[request.entry];
+        Build build;
+        build.entry = request.entry;
+        build.program = glCreateProgram();
+        std::vector<const char*> sources;
+        for (const std::string& source : request.sources)
+            sources.push_back(source.c_str());
+        build.cacheKey = ShaderCache::MakeKey(sources);
+        ShaderCache::Prepare(build.program);
+        for (size_t s = 0; s < entry.stages.size(); ++s)
+        {
+            unsigned int shader = glCreateShader(entry.stages[s].type);
+            glShaderSource(shader, 1, &sources[s], NULL);
+            glCompileShader(shader);
+            glAttachShader(build.program, shader);
+            build.shaders.push_back(shader);
+        }
+        glLinkProgram(build.program);
+        building.push_back(build);
+    }
+
+    static bool isComplete(unsigned int program)
+    {
+        if (!parallelCompile())
+            return true;
+        int complete = GL_TRUE;
+        glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete == GL_TRUE;
+    }
+
+    void finish(const Build& build)
+    {
+        unsigned int* target = entries[build.entry].program;
+        const std::vector<Stage>& stages = entries[build.entry].stages;
+        int success;
+        glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+        if (success)
+        {
+            copyUniforms(*target, build.program);
+            ShaderCache::Store(build.program, build.cacheKey);
+            // the old ID may be handed out again; its sampler units must be set anew then
+            MaterialBindings::Forget(*target);
+            glDeleteProgram(*target);
+            *target = build.program;
+            std::cout << "SHADER_WATCHER: reloaded " << stages.back().path << std::endl;
+        }
+        else
+        {
+            char infoLog[1024];
+            for (size_t s = 0; s < build.shaders.size(); ++s)
+            {
+                glGetShaderiv(build.shaders[s], GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    glGetShaderInfoLog(build.shaders[s], 1024, NULL, infoLog);
+                    std::cout << "ERROR::SHADER_WATCHER: " << stages[s].path << "\n" << infoLog << std::endl;
+                }
+            }
+            glGetProgramInfoLog(build.program, 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER_WATCHER: keeping previous program, link failed\n" << infoLog << std::endl;
+            glDeleteProgram(build.program);
+        }
+        for (unsigned int shader : build.shaders)
+            glDeleteShader(shader);
+    }
+
+    // carries the default-block uniform values of the old program over to its replacement. The values
+    // are set through glUniform* on the bound program, since glProgramUniform* needs GL 4.1 and the
+    // samples ask for a 3.3 context.
+    static void copyUniforms(unsigned int from, unsigned int to)
+    {
+        int current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        glUseProgram(to);
+        int count = 0;
+        glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count);
+        for (int i = 0; i < count; ++i)
+        {
+            char name[256];
+            int size;
+            GLenum type;
+            glGetActiveUniform(from, i, sizeof(name), NULL, &size, &type, name);
+            if (glGetUniformLocation(from, name) < 0)
+                continue; // uniform block member
+            // arrays are reported as "name[0]"; copy each element on its own
+            std::string base = name;
+            size_t bracket = base.find('[');
+            if (bracket != std::string::npos)
+                base = base.substr(0, bracket);
+            for (int element = 0; element < size; ++element)
+            {
+                std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : std::string(name);
+                int src = glGetUniformLocation(from, elementName.c_str());
+                int dst = glGetUniformLocation(to, elementName.c_str());
+                if (src < 0 || dst < 0)
+                    continue;
+                copyUniform(from, src, dst, type);
+            }
+        }
+        glUseProgram(current);
+    }
+
+    // sampler and image uniforms hold a texture unit, set like an int
+    static bool isUnit(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW:
+        case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_SAMPLER_CUBE_MAP_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+        case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_2D_RECT: case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE: case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE: case GL_UNSIGNED_INT_SAMPLER_2D_RECT: case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+            return true;
+        default:
+            // GL_IMAGE_1D ... GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY
+            return type >= GL_IMAGE_1D && type <= GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY;
+        }
+    }
+
+    // copies one uniform from the old program into the bound one; types not listed (doubles, which
+    // need GL 4.0) keep the new program's default
+    static void copyUniform(unsigned int from, int src, int dst, GLenum type)
+    {
+        float f[16];
+        int i[4];
+        unsigned int u[4];
+        switch (type)
+        {
+        case GL_FLOAT:             glGetUniformfv(from, src, f); glUniform1fv(dst, 1, f); break;
+        case GL_FLOAT_VEC2:        glGetUniformfv(from, src, f); glUniform2fv(dst, 1, f); break;
+        case GL_FLOAT_VEC3:        glGetUniformfv(from, src, f); glUniform3fv(dst, 1, f); break;
+        case GL_FLOAT_VEC4:        glGetUniformfv(from, src, f); glUniform4fv(dst, 1, f); break;
+        case GL_FLOAT_MAT2:        glGetUniformfv(from, src, f); glUniformMatrix2fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3:        glGetUniformfv(from, src, f); glUniformMatrix3fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4:        glGetUniformfv(from, src, f); glUniformMatrix4fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT2x3:      glGetUniformfv(from, src, f); glUniformMatrix2x3fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT2x4:      glGetUniformfv(from, src, f); glUniformMatrix2x4fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3x2:      glGetUniformfv(from, src, f); glUniformMatrix3x2fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3x4:      glGetUniformfv(from, src, f); glUniformMatrix3x4fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4x2:      glGetUniformfv(from, src, f); glUniformMatrix4x2fv(dst, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4x3:      glGetUniformfv(from, src, f); glUniformMatrix4x3fv(dst, 1, GL_FALSE, f); break;
+        // booleans read back as 0 or 1 and are set through the int entry points
+        case GL_INT: case GL_BOOL:           glGetUniformiv(from, src, i); glUniform1iv(dst, 1, i); break;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glGetUniformiv(from, src, i); glUniform2iv(dst, 1, i); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glGetUniformiv(from, src, i); glUniform3iv(dst, 1, i); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glGetUniformiv(from, src, i); glUniform4iv(dst, 1, i); break;
+        case GL_UNSIGNED_INT:      glGetUniformuiv(from, src, u); glUniform1uiv(dst, 1, u); break;
+        case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(from, src, u); glUniform2uiv(dst, 1, u); break;
+        case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(from, src, u); glUniform3uiv(dst, 1, u); break;
+        case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(from, src, u); glUniform4uiv(dst, 1, u); break;
+        default:
+            if (isUnit(type))
+            {
+                glGetUniformiv(from, src, i);
+                glUniform1iv(dst, 1, i);
+            }
+            break;
+        }
+    }
+};
+#endif
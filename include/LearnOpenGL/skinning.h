@@ -0,0 +1,308 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader_c.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOGL_SKINNING_SSE
+#endif
+
+// A skinned vertex as pre-skinning writes it; vec4s keep the std430 layout of the compute shader.
+// Drawn through PreSkinnedMesh, the fields feed attributes 0, 1, 3 and 4 like a Vertex does.
+struct SkinnedVertex {
+    glm::vec4 Position;
+    glm::vec4 Normal;
+    glm::vec4 Tangent;
+    glm::vec4 Bitangent;
+};
+
+// CPU pre-skinning, the reference for resources/shaders/skinning.cs and the fallback where compute
+// shaders are not available. Each vertex blends its bones' matrices by weight and transforms
+// position, normal, tangent and bitangent by the result; influences with an id outside the palette
+// are ignored and vertices without any stay in the bind pose.
+class Skinning
+{
+public:
+    static void SkinVertices(const Vertex* vertices, size_t count, const glm::mat4* palette, unsigned int boneCount, SkinnedVertex* out)
+    {
+        for (size_t i = 0; i < count; i++)
+            skinVertex(vertices[i], palette, boneCount, out[i]);
+    }
+
+private:
+    static glm::vec4 direction(float x, float y, float z)
+    {
+        float length2 = x * x + y * y + z * z;
+        float scale = length2 > 0.0f ? 1.0f / std::sqrt(length2) : 1.0f;
+        return glm::vec4(x * scale, y * scale, z * scale, 0.0f);
+    }
+
+#ifdef LOGL_SKINNING_SSE
+    static void skinVertex(const Vertex& v, const glm::mat4* palette, unsigned int boneCount, SkinnedVertex& out)
+    {
+        // the four columns of the blended matrix
+        __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps(), c2 = _mm_setzero_ps(), c3 = _mm_setzero_ps();
+        float total = 0.0f;
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            int id = v.m_BoneIDs[k];
+            if (id < 0 || id >= static_cast<int>(boneCount))
+                continue;
+            const float* m = &palette[id][0][0];
+            __m128 w = _mm_set1_ps(v.m_Weights[k]);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+            total += v.m_Weights[k];
+        }
+        if (total == 0.0f)
+        {
+            c0 = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+            c1 = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+            c2 = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+            c3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+
+        auto transform = [&](const glm::vec3& d) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(d.x)), _mm_mul_ps(c1, _mm_set1_ps(d.y))), _mm_mul_ps(c2, _mm_set1_ps(d.z)));
+        };
+        alignas(16) float result[4];
+        _mm_store_ps(result, _mm_add_ps(transform(v.Position), c3));
+        out.Position = glm::vec4(result[0], result[1], result[2], 1.0f);
+        _mm_store_ps(result, transform(v.Normal));
+        out.Normal = direction(result[0], result[1], result[2]);
+        _mm_store_ps(result, transform(v.Tangent));
+        out.Tangent = direction(result[0], result[1], result[2]);
+        _mm_store_ps(result, transform(v.Bitangent));
+        out.Bitangent = direction(result[0], result[1], result[2]);
+    }
+#else
+    static void skinVertex(const Vertex& v, const glm::mat4* palette, unsigned int boneCount, SkinnedVertex& out)
+    {
+        glm::mat4 skin(0.0f);
+        float total = 0.0f;
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            int id = v.m_BoneIDs[k];
+            if (id < 0 || id >= static_cast<int>(boneCount))
+                continue;
+            skin += palette[id] * v.m_Weights[k];
+            total += v.m_Weights[k];
+        }
+        if (total == 0.0f)
+            skin = glm::mat4(1.0f);
+        glm::mat3 rotation(skin);
+        glm::vec3 n = rotation * v.Normal, t = rotation * v.Tangent, b = rotation * v.Bitangent;
+        out.Position = glm::vec4(glm::vec3(skin * glm::vec4(v.Position, 1.0f)), 1.0f);
+        out.Normal = direction(n.x, n.y, n.z);
+        out.Tangent = direction(t.x, t.y, t.z);
+        out.Bitangent = direction(b.x, b.y, b.z);
+    }
+#endif
+};
+
+// The GPU side of pre-skinning one mesh: the bind pose as compute shader input, an output buffer
+// that is rewritten each frame, and a VAO that draws the output with the mesh's own indices. Every
+// pass that frame (shadow maps, depth prepass, lighting) then draws the skinned result with a
+// non-skinning shader instead of skinning again. Under CPU_DATA_RELEASE the bind pose is read back
+// from the mesh's vertex buffer, which only works for VERTEX_LAYOUT_FULL.
+class PreSkinnedMesh
+{
+public:
+    explicit PreSkinnedMesh(const Mesh& mesh)
+        : bindPose(mesh.vertices), indexCount(mesh.lods[0].indexCount), indexOffset(mesh.lods[0].indexOffset)
+    {
+        if (bindPose.empty() && mesh.vertexCount > 0)
+        {
+            if (mesh.layout == VERTEX_LAYOUT_FULL)
+            {
+                // the GPU copy holds the Vertex structs as they were
+                bindPose.resize(mesh.vertexCount);
+                glBindBuffer(GL_COPY_READ_BUFFER, mesh.VertexBuffer());
+                glGetBufferSubData(GL_COPY_READ_BUFFER, 0, bindPose.size() * sizeof(Vertex), bindPose.data());
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            else
+                std::cout << "ERROR::SKINNING: mesh was loaded without its CPU data in a compact layout, nothing to skin" << std::endl;
+        }
+
+        glGenBuffers(1, &outputBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, outputBuffer);
+        glBufferData(GL_ARRAY_BUFFER, bindPose.size() * sizeof(SkinnedVertex), nullptr, GL_DYNAMIC_DRAW);
+
+        std::vector<glm::vec2> texCoords(bindPose.size());
+        for (size_t i = 0; i < bindPose.size(); i++)
+            texCoords[i] = bindPose[i].TexCoords;
+        glGenBuffers(1, &texCoordBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
+        glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
+
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexBuffer());
+        glBindBuffer(GL_ARRAY_BUFFER, outputBuffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Normal));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void*)offsetof(SkinnedVertex, Bitangent));
+        glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glBindVertexArray(0);
+
+        if (GLAD_GL_VERSION_4_3)
+        {
+            std::vector<SkinInput> inputs(bindPose.size());
+            for (size_t i = 0; i < bindPose.size(); i++)
+            {
+                const Vertex& v = bindPose[i];
+                inputs[i] = { glm::vec4(v.Position, 1.0f), glm::vec4(v.Normal, 0.0f), glm::vec4(v.Tangent, 0.0f), glm::vec4(v.Bitangent, 0.0f),
+                              glm::ivec4(v.m_BoneIDs[0], v.m_BoneIDs[1], v.m_BoneIDs[2], v.m_BoneIDs[3]),
+                              glm::vec4(v.m_Weights[0], v.m_Weights[1], v.m_Weights[2], v.m_Weights[3]) };
+            }
+            glGenBuffers(1, &inputBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, inputs.size() * sizeof(SkinInput), inputs.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    ~PreSkinnedMesh()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &outputBuffer);
+        glDeleteBuffers(1, &texCoordBuffer);
+        if (inputBuffer)
+            glDeleteBuffers(1, &inputBuffer);
+    }
+
+    PreSkinnedMesh(const PreSkinnedMesh&) = delete;
+    PreSkinnedMesh& operator=(const PreSkinnedMesh&) = delete;
+
+    size_t VertexCount() const { return bindPose.size(); }
+    unsigned int OutputBuffer() const { return outputBuffer; }
+
+    // skins on the CPU (in parallel on the shared thread pool) and uploads the result
+    void SkinOnCpu(const glm::mat4* palette, unsigned int boneCount)
+    {
+        const size_t CHUNK = 4096;
+        cpuOutput.resize(bindPose.size());
+        size_t chunks = (bindPose.size() + CHUNK - 1) / CHUNK;
+        ThreadPool::Shared().ParallelFor(chunks, [&](size_t chunk) {
+            size_t first = chunk * CHUNK, count = std::min(CHUNK, bindPose.size() - first);
+            Skinning::SkinVertices(bindPose.data() + first, count, palette, boneCount, cpuOutput.data() + first);
+        });
+        glBindBuffer(GL_ARRAY_BUFFER, outputBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, cpuOutput.size() * sizeof(SkinnedVertex), cpuOutput.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // result of the last SkinOnCpu
+    const std::vector<SkinnedVertex>& CpuOutput() const { return cpuOutput; }
+
+    // reads the output buffer back, e.g. to compare the compute result with SkinOnCpu
+    void ReadBack(std::vector<SkinnedVertex>& out) const
+    {
+        out.resize(bindPose.size());
+        glBindBuffer(GL_ARRAY_BUFFER, outputBuffer);
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, out.size() * sizeof(SkinnedVertex), out.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // draws the skinned full-detail mesh with whatever shader and textures are bound
+    void Draw() const
+    {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)(indexOffset * sizeof(unsigned int)));
+        glBindVertexArray(0);
+    }
+
+private:
+    friend class ComputeSkinner;
+
+    // matches SkinInput in skinning.cs
+    struct SkinInput
+    {
+        glm::vec4 position, normal, tangent, bitangent;
+        glm::ivec4 boneIds;
+        glm::vec4 weights;
+    };
+
+    std::vector<Vertex> bindPose;
+    std::vector<SkinnedVertex> cpuOutput;
+    unsigned int indexCount, indexOffset;
+    unsigned int VAO = 0, outputBuffer = 0, texCoordBuffer = 0, inputBuffer = 0;
+};
+
+// Runs resources/shaders/skinning.cs. Per frame: SetPalette with a character's bones, Skin each of
+// its meshes, and Finish once before the first pass draws the results. Needs GL 4.3; without it,
+// use PreSkinnedMesh::SkinOnCpu.
+class ComputeSkinner
+{
+public:
+    static bool Supported() { return GLAD_GL_VERSION_4_3 != 0; }
+
+    explicit ComputeSkinner(const char* computePath) : shader(computePath)
+    {
+        glGenBuffers(1, &paletteBuffer);
+    }
+
+    ~ComputeSkinner()
+    {
+        glDeleteBuffers(1, &paletteBuffer);
+    }
+
+    ComputeSkinner(const ComputeSkinner&) = delete;
+    ComputeSkinner& operator=(const ComputeSkinner&) = delete;
+
+    void SetPalette(const glm::mat4* palette, unsigned int count)
+    {
+        boneCount = count;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, paletteBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::mat4), palette, GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void Skin(PreSkinnedMesh& mesh)
+    {
+        if (!mesh.inputBuffer || mesh.bindPose.empty())
+            return;
+        shader.use();
+        shader.setInt("vertexCount", static_cast<int>(mesh.bindPose.size()));
+        shader.setInt("boneCount", static_cast<int>(boneCount));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh.inputBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, paletteBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mesh.outputBuffer);
+        glDispatchCompute(static_cast<GLuint>((mesh.bindPose.size() + 63) / 64), 1, 1);
+    }
+
+    // makes the outputs visible to vertex fetch (and to ReadBack)
+    void Finish()
+    {
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+
+private:
+    ComputeShader shader;
+    unsigned int paletteBuffer = 0;
+    unsigned int boneCount = 0;
+};
+#endif
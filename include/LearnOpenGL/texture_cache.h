@@ -0,0 +1,401 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include "stb_image.h"
+
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/load_profile.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide cache of 2D textures loaded from image files, shared by every Model. Entries are
+// keyed on the canonical file path plus the load parameters, so the same image is decoded and
+// uploaded once however many models reference it. Each Acquire must be paired with a Release;
+// textures nobody holds stay resident for reuse until the GPU memory budget is exceeded, at which
+// point the least recently released ones are deleted.
+class TextureCache
+{
+public:
+    struct Stats
+    {
+        size_t hits = 0, misses = 0, evictions = 0;
+        size_t bytes = 0;    // estimated GPU memory of all resident textures, mip chains included
+        size_t textures = 0;
+    };
+
+    static TextureCache& Shared()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // returns the texture for the image at path, loading it on first use. gamma loads the color
+    // channels as sRGB; channels forces the component count (0 keeps the file's). Failed loads
+    // return 0 and are not cached.
+    unsigned int Acquire(const std::string& path, bool gamma = false, int channels = 0)
+    {
+        std::string key = makeKey(path, gamma, channels);
+        auto found = entries.find(key);
+        if (found != entries.end())
+        {
+            Entry& entry = found->second;
+            if (entry.references++ == 0)
+                idle.erase(entry.idlePosition);
+            stats.hits++;
+            return entry.id;
+        }
+
+        stats.misses++;
+        size_t bytes = 0;
+        unsigned int id = load(path, gamma, channels, bytes);
+        if (id == 0)
+            return 0;
+        Entry& entry = entries[key];
+        entry.id = id;
+        entry.bytes = bytes;
+        entry.references = 1;
+        keys[id] = key;
+        stats.bytes += bytes;
+        stats.textures++;
+        evict();
+        return id;
+    }
+
+    // like Acquire, but returns at once. The texture starts as a grey 1x1 placeholder while a worker
+    // thread decodes the image and builds its mip chain; StreamUploads then fills the texture from the
+    // smallest mip up, so it sharpens progressively. The texture ID never changes.
+    unsigned int AcquireStreamed(const std::string& path, bool gamma = false, int channels = 0)
+    {
+        std::string key = makeKey(path, gamma, channels);
+        auto found = entries.find(key);
+        if (found != entries.end())
+        {
+            Entry& entry = found->second;
+            if (entry.references++ == 0)
+                idle.erase(entry.idlePosition);
+            stats.hits++;
+            return entry.id;
+        }
+
+        stats.misses++;
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        const unsigned char grey[4] = { 128, 128, 128, 255 };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        Entry& entry = entries[key];
+        entry.id = textureID;
+        entry.bytes = 4;
+        entry.references = 1;
+        entry.streaming = true;
+        keys[textureID] = key;
+        stats.bytes += entry.bytes;
+        stats.textures++;
+
+        auto job = std::make_shared<StreamJob>();
+        job->path = path;
+        job->gamma = gamma;
+        job->channels = channels;
+        job->id = textureID;
+        ThreadPool::Shared().Submit([job] { job->Decode(); });
+        streaming.push_back(job);
+        return textureID;
+    }
+
+    // whether a texture from AcquireStreamed is still missing mip levels
+    bool IsStreaming(unsigned int id) const
+    {
+        auto key = keys.find(id);
+        return key != keys.end() && entries.at(key->second).streaming;
+    }
+
+    size_t StreamingCount() const { return streaming.size(); }
+
+    // uploads decoded image data of streamed textures, a mip level (or a band of rows of a large
+    // level) at a time, until the deadline passes. Call once per frame on the thread that owns the
+    // context; returns whether uploads remain.
+    bool StreamUploads(std::chrono::steady_clock::time_point deadline)
+    {
+        LoadProfile::Timer timer(LoadProfile::TEXTURE_UPLOAD);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (auto job = streaming.begin(); job != streaming.end() && std::chrono::steady_clock::now() < deadline; )
+        {
+            StreamJob& stream = **job;
+            if (!stream.decoded.load(std::memory_order_acquire))
+            {
+                ++job;
+                continue;
+            }
+            Entry& entry = entries[keys[stream.id]];
+            if (stream.levels.empty())
+            {
+                std::cout << "Texture failed to load at path: " << stream.path << std::endl;
+                entry.streaming = false;
+                job = streaming.erase(job);
+                continue;
+            }
+
+            glBindTexture(GL_TEXTURE_2D, stream.id);
+            if (stream.level < 0)
+            {
+                // allocate the whole chain, then fill every level up to 64 texels in one go
+                int levels = static_cast<int>(stream.levels.size());
+                for (int level = 0; level < levels; level++)
+                    glTexImage2D(GL_TEXTURE_2D, level, stream.internalFormat, stream.Width(level), stream.Height(level), 0, stream.format, GL_UNSIGNED_BYTE, nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+                stream.level = levels - 1;
+                while (stream.level > 0 && std::max(stream.Width(stream.level - 1), stream.Height(stream.level - 1)) <= 64)
+                    stream.level--;
+                for (int level = levels - 1; level >= stream.level; level--)
+                    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, stream.Width(level), stream.Height(level), stream.format, GL_UNSIGNED_BYTE, stream.levels[level].data());
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, stream.level);
+                stats.bytes += stream.bytes - entry.bytes;
+                entry.bytes = stream.bytes;
+            }
+            else
+            {
+                // next finer level, in bands of about 256 KB so a large level spans several frames
+                int level = stream.level - 1, width = stream.Width(level), height = stream.Height(level);
+                size_t rowBytes = size_t(width) * stream.components;
+                int rows = std::min(height - stream.row, std::max(1, static_cast<int>((256 * 1024) / rowBytes)));
+                glTexSubImage2D(GL_TEXTURE_2D, level, 0, stream.row, width, rows, stream.format, GL_UNSIGNED_BYTE,
+                                stream.levels[level].data() + stream.row * rowBytes);
+                stream.row += rows;
+                if (stream.row == height)
+                {
+                    stream.level = level;
+                    stream.row = 0;
+                    std::vector<unsigned char>().swap(stream.levels[level + 1]);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+                }
+            }
+            if (stream.level == 0)
+            {
+                entry.streaming = false;
+                job = streaming.erase(job);
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        return !streaming.empty();
+    }
+
+    // takes another reference to a texture returned by Acquire
+    void AddReference(unsigned int id)
+    {
+        auto key = keys.find(id);
+        if (key == keys.end())
+            return;
+        Entry& entry = entries[key->second];
+        if (entry.references++ == 0)
+            idle.erase(entry.idlePosition);
+    }
+
+    void Release(unsigned int id)
+    {
+        auto key = keys.find(id);
+        if (key == keys.end())
+            return;
+        Entry& entry = entries[key->second];
+        if (entry.references == 0 || --entry.references > 0)
+            return;
+        entry.idlePosition = idle.insert(idle.end(), key->second);
+        evict();
+    }
+
+    // GPU memory the cache may keep resident; only textures without references are evicted
+    void SetBudget(size_t bytes)
+    {
+        budget = bytes;
+        evict();
+    }
+
+    size_t Budget() const { return budget; }
+
+    // deletes every texture nobody holds
+    void Trim()
+    {
+        size_t keep = budget;
+        budget = 0;
+        evict();
+        budget = keep;
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Entry
+    {
+        unsigned int id = 0;
+        size_t bytes = 0;
+        unsigned int references = 0;
+        bool streaming = false;                        // mip levels still to come from StreamUploads
+        std::list<std::string>::iterator idlePosition; // valid while references == 0
+    };
+
+    // an image on its way in through AcquireStreamed; the worker fills everything up to decoded
+    struct StreamJob
+    {
+        std::string path;
+        bool gamma = false;
+        int channels = 0;
+        unsigned int id = 0;
+        int width = 0, height = 0, components = 0;
+        GLenum format = GL_RGBA, internalFormat = GL_RGBA8;
+        std::vector<std::vector<unsigned char>> levels; // full mip chain, empty if decoding failed
+        size_t bytes = 0;
+        std::atomic<bool> decoded{ false };
+        // upload progress, GL thread only
+        int level = -1; // finest level uploaded so far, -1 before the chain is allocated
+        int row = 0;    // rows of level - 1 uploaded so far
+
+        int Width(int level) const { return std::max(1, width >> level); }
+        int Height(int level) const { return std::max(1, height >> level); }
+
+        void Decode()
+        {
+            LoadProfile::Timer timer(LoadProfile::TEXTURE_DECODE);
+            unsigned char *data = stbi_load(path.c_str(), &width, &height, &components, channels);
+            if (data)
+            {
+                if (channels != 0)
+                    components = channels;
+                formats(components, gamma, format, internalFormat);
+                levels.emplace_back(data, data + size_t(width) * height * components);
+                stbi_image_free(data);
+                // box-filtered mip chain down to 1x1
+                for (int level = 1; Width(level - 1) > 1 || Height(level - 1) > 1; level++)
+                {
+                    const std::vector<unsigned char>& source = levels[level - 1];
+                    int sourceWidth = Width(level - 1), sourceHeight = Height(level - 1), w = Width(level), h = Height(level);
+                    std::vector<unsigned char> mip(size_t(w) * h * components);
+                    for (int y = 0; y < h; y++)
+                        for (int x = 0; x < w; x++)
+                            for (int c = 0; c < components; c++)
+                            {
+                                int x0 = std::min(2 * x, sourceWidth - 1), x1 = std::min(2 * x + 1, sourceWidth - 1);
+                                int y0 = std::min(2 * y, sourceHeight - 1), y1 = std::min(2 * y + 1, sourceHeight - 1);
+                                int sum = source[(size_t(y0) * sourceWidth + x0) * components + c] + source[(size_t(y0) * sourceWidth + x1) * components + c]
+                                        + source[(size_t(y1) * sourceWidth + x0) * components + c] + source[(size_t(y1) * sourceWidth + x1) * components + c];
+                                mip[(size_t(y) * w + x) * components + c] = static_cast<unsigned char>((sum + 2) / 4);
+                            }
+                    levels.push_back(std::move(mip));
+                }
+                bytes = size_t(width) * height * (components == 3 ? 4 : components) * 4 / 3;
+            }
+            decoded.store(true, std::memory_order_release);
+        }
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<unsigned int, std::string> keys; // texture id -> entry key
+    std::list<std::string> idle;                        // unreferenced entries, least recently released first
+    std::list<std::shared_ptr<StreamJob>> streaming;    // textures from AcquireStreamed that are not complete yet
+    size_t budget = size_t(512) << 20;
+    Stats stats;
+
+    TextureCache() = default;
+
+    static std::string makeKey(const std::string& path, bool gamma, int channels)
+    {
+        std::error_code ec;
+        std::string key = std::filesystem::weakly_canonical(path, ec).generic_string();
+        if (ec)
+            key = path;
+        key += gamma ? "|srgb|" : "|linear|";
+        key += std::to_string(channels);
+        return key;
+    }
+
+    void evict()
+    {
+        while (stats.bytes > budget && !idle.empty())
+        {
+            auto found = entries.find(idle.front());
+            idle.pop_front();
+            if (found->second.streaming)
+            {
+                unsigned int id = found->second.id;
+                streaming.remove_if([id](const std::shared_ptr<StreamJob>& job) { return job->id == id; });
+            }
+            glDeleteTextures(1, &found->second.id);
+            keys.erase(found->second.id);
+            stats.bytes -= found->second.bytes;
+            stats.textures--;
+            stats.evictions++;
+            entries.erase(found);
+        }
+    }
+
+    static void formats(int components, bool gamma, GLenum& format, GLenum& internalFormat)
+    {
+        if (components == 1)
+            format = GL_RED, internalFormat = GL_R8;
+        else if (components == 2)
+            format = GL_RG, internalFormat = GL_RG8;
+        else if (components == 3)
+            format = GL_RGB, internalFormat = gamma ? GL_SRGB8 : GL_RGB8;
+        else
+            format = GL_RGBA, internalFormat = gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    }
+
+    static unsigned int load(const std::string& path, bool gamma, int channels, size_t& bytes)
+    {
+        int width, height, nrComponents;
+        unsigned char *data;
+        {
+            LoadProfile::Timer timer(LoadProfile::TEXTURE_DECODE);
+            data = stbi_load(path.c_str(), &width, &height, &nrComponents, channels);
+        }
+        if (!data)
+        {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            return 0;
+        }
+        if (channels != 0)
+            nrComponents = channels;
+
+        GLenum format, internalFormat;
+        formats(nrComponents, gamma, format, internalFormat);
+        LoadProfile::Timer timer(LoadProfile::TEXTURE_UPLOAD);
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        stbi_image_free(data);
+        // RGB is padded to four bytes by most drivers; the mip chain adds a third
+        bytes = size_t(width) * height * (nrComponents == 3 ? 4 : nrComponents) * 4 / 3;
+        return textureID;
+    }
+};
+#endif
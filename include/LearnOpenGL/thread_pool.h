@@ -0,0 +1,146 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from a shared queue. Jobs must not touch OpenGL: the
+// context is only current on the thread that created it, so work is split into a CPU part that
+// runs here and a GL part that the caller performs afterwards.
+class ThreadPool
+{
+public:
+    // a pool with one worker per hardware thread, minus the calling thread
+    static ThreadPool& Shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    explicit ThreadPool(unsigned int threads = 0)
+    {
+        if (threads == 0)
+        {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            threads = hardware > 1 ? hardware - 1 : 1;
+        }
+        for (unsigned int i = 0; i < threads; ++i)
+            workers.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int Size() const { return static_cast<unsigned int>(workers.size()); }
+
+    // queues a job; the future reports its completion (and rethrows its exception)
+    std::future<void> Submit(std::function<void()> job)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::move(job));
+        std::future<void> done = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back([task] { (*task)(); });
+        }
+        wake.notify_one();
+        return done;
+    }
+
+    // runs body(i) for every i in [0, count) and returns when all are done. The calling thread takes
+    // part and only waits for indices other threads have already claimed, so this never deadlocks
+    // when called from inside a job. If body throws, the indices not yet started are skipped and the
+    // first exception is rethrown here once no thread is using body any more.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body)
+    {
+        if (count == 0)
+            return;
+        struct Progress
+        {
+            std::atomic<size_t> next{ 0 }, done{ 0 };
+            std::atomic<bool> failed{ false };
+            std::exception_ptr error; // the first exception thrown by body
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto progress = std::make_shared<Progress>();
+        // helpers that start after everything was claimed return without touching body
+        auto run = [progress, count, &body] {
+            for (size_t i = progress->next++; i < count; i = progress->next++)
+            {
+                if (!progress->failed)
+                {
+                    try
+                    {
+                        body(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(progress->mutex);
+                        if (!progress->error)
+                            progress->error = std::current_exception();
+                        progress->failed = true;
+                    }
+                }
+                // a failed or skipped index counts as done, so the caller's wait still ends
+                if (++progress->done == count)
+                {
+                    std::lock_guard<std::mutex> lock(progress->mutex);
+                    progress->finished.notify_all();
+                }
+            }
+        };
+        size_t helpers = std::min<size_t>(workers.size(), count - 1);
+        for (size_t i = 0; i < helpers; ++i)
+            Submit(run);
+        run();
+        std::unique_lock<std::mutex> lock(progress->mutex);
+        progress->finished.wait(lock, [&] { return progress->done == count; });
+        if (progress->error)
+            std::rethrow_exception(progress->error);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void work()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping && queue.empty())
+                    return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+    }
+};
+#endif
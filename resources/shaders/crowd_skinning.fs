@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 lightDirection; // towards the light
+
+void main()
+{
+    vec3 color = texture(texture_diffuse1, TexCoords).rgb;
+    float diffuse = max(dot(normalize(Normal), normalize(lightDirection)), 0.0);
+    FragColor = vec4(color * (0.3 + 0.7 * diffuse), 1.0);
+}
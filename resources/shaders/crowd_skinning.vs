@@ -0,0 +1,41 @@
+#version 430 core
+// Skinning for characters animated by CrowdAnimator: every character's bones live in one storage
+// buffer (CrowdAnimator::Bind) and a draw only picks its character's range through paletteOffset.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in ivec4 boneIds;
+layout (location = 6) in vec4 weights;
+
+layout(std430, binding = 0) readonly buffer BonePalettes { mat4 bones[]; };
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform int paletteOffset; // CrowdAnimator::PaletteOffset(character)
+
+const int MAX_BONES = 100; // Animator::MAX_BONES
+const int MAX_BONE_INFLUENCE = 4;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+void main()
+{
+    mat4 skin = mat4(0.0);
+    float total = 0.0;
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        if (boneIds[i] < 0 || boneIds[i] >= MAX_BONES)
+            continue;
+        skin += bones[paletteOffset + boneIds[i]] * weights[i];
+        total += weights[i];
+    }
+    // vertices without influences stay in the bind pose
+    if (total == 0.0)
+        skin = mat4(1.0);
+
+    gl_Position = projection * view * model * skin * vec4(aPos, 1.0);
+    Normal = mat3(model) * mat3(skin) * aNormal;
+    TexCoords = aTexCoords;
+}
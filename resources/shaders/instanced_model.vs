@@ -0,0 +1,20 @@
+#version 330 core
+// For SceneGraph::DrawInstanced and Model::DrawInstanced: the model matrix is a per-instance
+// attribute (INSTANCE_MATRIX_ATTRIBUTE in mesh.h) rather than a uniform.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 7) in mat4 aInstanceMatrix;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+void main()
+{
+    gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0);
+    Normal = mat3(aInstanceMatrix) * aNormal;
+    TexCoords = aTexCoords;
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// A flat shadow: the geometry was squashed onto the ground along the light, only darkening is left.
+out vec4 FragColor;
+
+uniform float shadowStrength;
+
+void main()
+{
+    FragColor = vec4(0.0, 0.0, 0.0, shadowStrength);
+}
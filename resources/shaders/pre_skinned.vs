@@ -0,0 +1,20 @@
+#version 330 core
+// Draws a PreSkinnedMesh: its vertices are already skinned (ComputeSkinner or SkinOnCpu), so every
+// pass reads them like a static mesh's.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+out vec2 TexCoords;
+out vec3 Normal;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Normal = mat3(model) * aNormal;
+    TexCoords = aTexCoords;
+}
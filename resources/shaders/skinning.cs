@@ -0,0 +1,64 @@
+#version 430 core
+// Pre-skinning: transforms every bind pose vertex of a mesh by its bones once per frame, so all
+// render passes can draw the result like a static mesh. Mirrors Skinning::SkinVertices in skinning.h.
+layout(local_size_x = 64) in;
+
+struct SkinInput
+{
+    vec4 position;
+    vec4 normal;
+    vec4 tangent;
+    vec4 bitangent;
+    ivec4 boneIds;
+    vec4 weights;
+};
+
+struct SkinOutput
+{
+    vec4 position;
+    vec4 normal;
+    vec4 tangent;
+    vec4 bitangent;
+};
+
+layout(std430, binding = 0) readonly buffer Inputs { SkinInput inputs[]; };
+layout(std430, binding = 1) readonly buffer Palette { mat4 bones[]; };
+layout(std430, binding = 2) writeonly buffer Outputs { SkinOutput outputs[]; };
+
+uniform int vertexCount;
+uniform int boneCount;
+
+// meshes without tangents carry zero vectors, which must stay zero rather than turn into NaN
+vec3 safeNormalize(vec3 v)
+{
+    float length2 = dot(v, v);
+    return length2 > 0.0 ? v * inversesqrt(length2) : v;
+}
+
+void main()
+{
+    int i = int(gl_GlobalInvocationID.x);
+    if (i >= vertexCount)
+        return;
+    SkinInput v = inputs[i];
+
+    mat4 skin = mat4(0.0);
+    float total = 0.0;
+    for (int k = 0; k < 4; k++)
+    {
+        int id = v.boneIds[k];
+        if (id < 0 || id >= boneCount)
+            continue;
+        skin += bones[id] * v.weights[k];
+        total += v.weights[k];
+    }
+    // vertices no bone influences stay in the bind pose
+    if (total == 0.0)
+        skin = mat4(1.0);
+
+    mat3 rotation = mat3(skin);
+    outputs[i].position = vec4((skin * vec4(v.position.xyz, 1.0)).xyz, 1.0);
+    outputs[i].normal = vec4(safeNormalize(rotation * v.normal.xyz), 0.0);
+    outputs[i].tangent = vec4(safeNormalize(rotation * v.tangent.xyz), 0.0);
+    outputs[i].bitangent = vec4(safeNormalize(rotation * v.bitangent.xyz), 0.0);
+}
@@ -0,0 +1,476 @@
+// Animation sampling benchmark and correctness harness. For every skinned asset it
+// - checks Animator's bone palettes against a plain reference evaluator (recursive hierarchy walk,
+//   name lookups, linear key scans) at many sample times, and optionally the clip compiled by
+//   AnimationCompiler against the same full-precision reference, measuring its reduction and quantization error;
+// - measures the cost of one sample per bone, for forward playback and for random seeks;
+// - measures crowd throughput (characters per second through CrowdAnimator::Update) with 1 to N threads;
+// - skins the asset's meshes with Skinning::SkinVertices at several poses and checks them against a
+//   scalar glm evaluation, timing both.
+// GL is stubbed out (GLCounter::NullLoader), so no GPU or display is needed. The exit code is
+// non-zero when a palette or a skinned vertex differs from the reference by more than its tolerance.
+//
+// usage: bench_anim [options] [asset ...]      (default asset: resources/objects/vampire/dancing_vampire.dae)
+// --samples <n>      sample times per correctness and cost run, 2000 by default
+// --characters <n>   characters in the throughput run, 500 by default
+// --frames <n>       frames per throughput run, 60 by default
+// --threads <n>      highest thread count in the throughput run, all hardware threads by default
+// --tolerance <x>    largest relative palette error accepted, 1e-4 by default
+// --compiled         also check and time the clip compiled by AnimationCompiler
+// --clip-tolerance <x> tolerance for the compiled clip, 5e-3 by default
+// --skin-tolerance <x> largest skinned position or normal error accepted, 1e-4 by default
+// --json <file>      write the results as JSON
+// ---------------------------------------------------------------------------------------------------------
+#include <glad/glad.h>
+
+#include "LearnOpenGL/gl_counter.h"
+#include "LearnOpenGL/model_animation.h"
+#include "LearnOpenGL/animation.h"
+#include "LearnOpenGL/animator.h"
+#include "LearnOpenGL/animation_compiler.h"
+#include "LearnOpenGL/crowd_animator.h"
+#include "LearnOpenGL/skinning.h"
+#include "LearnOpenGL/thread_pool.h"
+
+// model_animation.h only declares stb_image and this file is linked on its own (make bench_anim), so it
+// carries the implementation, the way model.h does for the other benchmarks. stb_image.h has no guard
+// around its implementation, so this must come after every header that includes it.
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The evaluator the optimized path is held to: the original LearnOpenGL algorithm, written for
+// clarity rather than speed. It is always evaluated on the clip as imported, never a compiled one.
+class ReferencePose
+{
+public:
+    explicit ReferencePose(Animation& animation) : animation(animation) {}
+
+    void Evaluate(float time, std::vector<glm::mat4>& palette)
+    {
+        palette.assign(Animator::MAX_BONES, glm::mat4(1.0f));
+        walk(animation.GetRootNode(), glm::mat4(1.0f), time, palette);
+    }
+
+private:
+    Animation& animation;
+
+    static int keyBefore(const std::vector<float>& times, float time)
+    {
+        for (int k = 0; k + 1 < static_cast<int>(times.size()); k++)
+            if (time < times[k + 1])
+                return k;
+        return static_cast<int>(times.size()) - 2;
+    }
+
+    static float factor(const std::vector<float>& times, int k, float time)
+    {
+        float span = times[k + 1] - times[k];
+        return span > 0.0f ? glm::clamp((time - times[k]) / span, 0.0f, 1.0f) : 0.0f;
+    }
+
+    static glm::mat4 local(const Bone& bone, float time)
+    {
+        glm::vec3 position(0.0f), scale(1.0f);
+        glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+        const std::vector<float>& positionTimes = bone.GetPositionTimes();
+        if (positionTimes.size() == 1)
+            position = bone.PositionKey(0);
+        else if (positionTimes.size() > 1)
+        {
+            int k = keyBefore(positionTimes, time);
+            position = glm::mix(bone.PositionKey(k), bone.PositionKey(k + 1), factor(positionTimes, k, time));
+        }
+        const std::vector<float>& rotationTimes = bone.GetRotationTimes();
+        if (rotationTimes.size() == 1)
+            rotation = glm::normalize(bone.RotationKey(0));
+        else if (rotationTimes.size() > 1)
+        {
+            int k = keyBefore(rotationTimes, time);
+            rotation = glm::normalize(glm::slerp(bone.RotationKey(k), bone.RotationKey(k + 1), factor(rotationTimes, k, time)));
+        }
+        const std::vector<float>& scaleTimes = bone.GetScaleTimes();
+        if (scaleTimes.size() == 1)
+            scale = bone.ScaleKey(0);
+        else if (scaleTimes.size() > 1)
+        {
+            int k = keyBefore(scaleTimes, time);
+            scale = glm::mix(bone.ScaleKey(k), bone.ScaleKey(k + 1), factor(scaleTimes, k, time));
+        }
+        return glm::translate(glm::mat4(1.0f), position) * glm::toMat4(rotation) * glm::scale(glm::mat4(1.0f), scale);
+    }
+
+    void walk(const AssimpNodeData& node, const glm::mat4& parent, float time, std::vector<glm::mat4>& palette)
+    {
+        glm::mat4 transform = node.transformation;
+        if (Bone* bone = animation.FindBone(node.name))
+            transform = local(*bone, time);
+        glm::mat4 global = parent * transform;
+        const std::map<std::string, BoneInfo>& infos = animation.GetBoneIDMap();
+        auto info = infos.find(node.name);
+        if (info != infos.end() && info->second.id >= 0 && info->second.id < static_cast<int>(palette.size()))
+            palette[info->second.id] = global * info->second.offset;
+        for (const AssimpNodeData& child : node.children)
+            walk(child, global, time, palette);
+    }
+};
+
+struct ClipResult
+{
+    std::string name;
+    size_t bones = 0, samples = 0;
+    double maxError = 0.0;
+    bool passed = true;
+    double forwardNsPerBone = 0.0, seekNsPerBone = 0.0;
+    std::vector<std::pair<unsigned int, double>> throughput; // threads, characters per second
+};
+
+// Skinning::SkinVertices on one asset against skinReference; skinning does not depend on how the
+// clip is stored, so it is checked once per asset rather than per ClipResult
+struct SkinResult
+{
+    std::string name;
+    size_t vertices = 0, poses = 0;
+    double maxError = 0.0;
+    bool passed = true;
+    double nsPerVertex = 0.0, referenceNsPerVertex = 0.0;
+};
+
+struct Options
+{
+    int samples = 2000, characters = 500, frames = 60;
+    unsigned int threads = 0;
+    double tolerance = 1e-4, clipTolerance = 5e-3, skinTolerance = 1e-4;
+    bool compiled = false;
+};
+
+// the time sequence an Animator follows for a sequence of dt, with the same float arithmetic
+float advance(float time, const Animation& animation, float dt)
+{
+    time += animation.GetTicksPerSecond() * dt;
+    return fmod(time, animation.GetDuration());
+}
+
+// largest palette difference, relative to the size of the reference entries
+double compare(const std::vector<glm::mat4>& actual, const std::vector<glm::mat4>& expected)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i < expected.size(); i++)
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+            {
+                double scale = std::max(1.0, std::fabs(static_cast<double>(expected[i][c][r])));
+                worst = std::max(worst, std::fabs(static_cast<double>(actual[i][c][r]) - expected[i][c][r]) / scale);
+            }
+    return worst;
+}
+
+// steps of 1/60 s for forward playback, or random jumps anywhere in the clip for seeks
+std::vector<float> timeSteps(const Animation& animation, int count, bool seek)
+{
+    std::mt19937 random(12345);
+    float clipSeconds = animation.GetDuration() / std::max(1.0f, animation.GetTicksPerSecond());
+    std::uniform_real_distribution<float> jump(0.0f, clipSeconds);
+    std::vector<float> steps(count);
+    for (float& dt : steps)
+        dt = seek ? jump(random) : 1.0f / 60.0f;
+    return steps;
+}
+
+// plays animation and compares it with the reference evaluated on source, the full-precision clip
+// animation was compiled from (or animation itself)
+void check(Animation& animation, Animation& source, const Options& options, double tolerance, ClipResult& result)
+{
+    ReferencePose reference(source);
+    Animator animator(&animation);
+    std::vector<glm::mat4> expected;
+    float time = 0.0f;
+    for (bool seek : { false, true })
+        for (float dt : timeSteps(animation, options.samples / 2, seek))
+        {
+            animator.UpdateAnimation(dt);
+            time = advance(time, animation, dt);
+            reference.Evaluate(time, expected);
+            result.maxError = std::max(result.maxError, compare(animator.GetFinalBoneMatrices(), expected));
+            result.samples++;
+        }
+    result.passed = result.maxError <= tolerance;
+}
+
+double nsPerBone(Animation& animation, const Options& options, bool seek)
+{
+    Animator animator(&animation);
+    std::vector<float> steps = timeSteps(animation, options.samples, seek);
+    for (int i = 0; i < 16; i++) // warm up
+        animator.UpdateAnimation(steps[i % steps.size()]);
+    auto start = std::chrono::steady_clock::now();
+    for (float dt : steps)
+        animator.UpdateAnimation(dt);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / (static_cast<double>(steps.size()) * animation.GetSkeleton().size());
+}
+
+// characters per second CrowdAnimator::Update animates, palettes included; they land in its CPU
+// staging copy, since the null GL cannot map buffers
+double charactersPerSecond(Animation& animation, const Options& options, unsigned int threads)
+{
+    CrowdAnimator crowd(static_cast<unsigned int>(options.characters));
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> offset(0.0f, 10.0f);
+    for (int i = 0; i < options.characters; i++)
+        crowd.Get(crowd.Add(&animation)).UpdateAnimation(offset(random)); // spread the characters over the clip
+
+    // the calling thread works too, so n threads need n - 1 workers
+    std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        crowd.Update(1.0f / 60.0f, pool.get());
+        crowd.EndFrame();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(crowd.Count()) * options.frames / seconds;
+}
+
+// one vertex skinned the plain way: every influence transforms the vertex on its own and the results
+// are blended by weight, rather than blending the matrices first as Skinning does
+SkinnedVertex skinReference(const Vertex& v, const std::vector<glm::mat4>& palette)
+{
+    glm::vec3 position(0.0f), normal(0.0f);
+    float total = 0.0f;
+    for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+    {
+        if (v.m_BoneIDs[k] < 0 || v.m_BoneIDs[k] >= static_cast<int>(palette.size()))
+            continue;
+        const glm::mat4& bone = palette[v.m_BoneIDs[k]];
+        position += v.m_Weights[k] * glm::vec3(bone * glm::vec4(v.Position, 1.0f));
+        normal += v.m_Weights[k] * (glm::mat3(bone) * v.Normal);
+        total += v.m_Weights[k];
+    }
+    if (total == 0.0f)
+    {
+        position = v.Position;
+        normal = v.Normal;
+    }
+    SkinnedVertex out;
+    out.Position = glm::vec4(position, 1.0f);
+    out.Normal = glm::vec4(glm::length(normal) > 0.0f ? glm::normalize(normal) : normal, 0.0f);
+    return out;
+}
+
+// largest position or normal difference, relative to the size of the reference coordinates
+double compare(const SkinnedVertex& actual, const SkinnedVertex& expected)
+{
+    double worst = 0.0;
+    for (int c = 0; c < 3; c++)
+    {
+        double scale = std::max(1.0, std::fabs(static_cast<double>(expected.Position[c])));
+        worst = std::max(worst, std::fabs(static_cast<double>(actual.Position[c]) - expected.Position[c]) / scale);
+        worst = std::max(worst, std::fabs(static_cast<double>(actual.Normal[c]) - expected.Normal[c]));
+    }
+    return worst;
+}
+
+// skins every mesh of model at poses spread over the clip; the meshes must keep their CPU vertices
+SkinResult checkSkinning(const std::string& name, Model& model, Animation& animation, const Options& options)
+{
+    const int POSES = 8;
+    SkinResult result;
+    result.name = name;
+    Animator animator(&animation);
+    std::vector<SkinnedVertex> skinned, expected;
+    double seconds = 0.0, referenceSeconds = 0.0;
+    float clipSeconds = animation.GetDuration() / std::max(1.0f, animation.GetTicksPerSecond());
+    for (int pose = 0; pose < POSES; pose++)
+    {
+        animator.UpdateAnimation(clipSeconds / POSES);
+        const std::vector<glm::mat4>& palette = animator.GetFinalBoneMatrices();
+        for (const Mesh& mesh : model.meshes)
+        {
+            skinned.resize(mesh.vertices.size());
+            expected.resize(mesh.vertices.size());
+            auto start = std::chrono::steady_clock::now();
+            Skinning::SkinVertices(mesh.vertices.data(), mesh.vertices.size(), palette.data(), static_cast<unsigned int>(palette.size()), skinned.data());
+            auto middle = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < mesh.vertices.size(); i++)
+                expected[i] = skinReference(mesh.vertices[i], palette);
+            auto end = std::chrono::steady_clock::now();
+            seconds += std::chrono::duration<double>(middle - start).count();
+            referenceSeconds += std::chrono::duration<double>(end - middle).count();
+            for (size_t i = 0; i < skinned.size(); i++)
+                result.maxError = std::max(result.maxError, compare(skinned[i], expected[i]));
+            result.vertices += mesh.vertices.size();
+        }
+        result.poses++;
+    }
+    result.passed = result.vertices > 0 && result.maxError <= options.skinTolerance;
+    if (result.vertices > 0)
+    {
+        result.nsPerVertex = seconds * 1e9 / result.vertices;
+        result.referenceNsPerVertex = referenceSeconds * 1e9 / result.vertices;
+    }
+
+    printf("\n%s: %zu vertices skinned at %zu poses\n", name.c_str(), result.vertices / std::max<size_t>(result.poses, 1), result.poses);
+    printf("  skinning error  %.3g (tolerance %.3g) %s\n", result.maxError, options.skinTolerance, result.passed ? "ok" : "FAILED");
+    printf("  SkinVertices    %8.2f ns per vertex   reference %8.2f ns per vertex\n", result.nsPerVertex, result.referenceNsPerVertex);
+    return result;
+}
+
+ClipResult run(const std::string& name, Animation& animation, Animation& source, const Options& options, double tolerance)
+{
+    ClipResult result;
+    result.name = name;
+    result.bones = animation.GetSkeleton().size();
+    check(animation, source, options, tolerance, result);
+    result.forwardNsPerBone = nsPerBone(animation, options, false);
+    result.seekNsPerBone = nsPerBone(animation, options, true);
+    unsigned int maxThreads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        result.throughput.push_back({ threads, charactersPerSecond(animation, options, threads) });
+        if (threads == maxThreads)
+            break;
+    }
+
+    printf("\n%s: %zu skeleton nodes, %zu samples\n", name.c_str(), result.bones, result.samples);
+    printf("  palette error   %.3g (tolerance %.3g) %s\n", result.maxError, tolerance, result.passed ? "ok" : "FAILED");
+    printf("  forward         %8.2f ns per bone per sample\n", result.forwardNsPerBone);
+    printf("  seek            %8.2f ns per bone per sample\n", result.seekNsPerBone);
+    for (const auto& entry : result.throughput)
+        printf("  %2u threads      %10.0f characters/s (%d characters: %.3f ms per frame)\n", entry.first, entry.second,
+               options.characters, options.characters / entry.second * 1e3);
+    return result;
+}
+
+bool writeJson(const std::string& path, const std::vector<ClipResult>& results, const std::vector<SkinResult>& skins)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::BENCHMARK: could not open " << path << std::endl;
+        return false;
+    }
+    file << "{\n  \"benchmark\": \"animation\",\n  \"clips\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const ClipResult& r = results[i];
+        file << "    { \"name\": \"" << r.name << "\", \"nodes\": " << r.bones << ", \"samples\": " << r.samples
+             << ", \"max_error\": " << r.maxError << ", \"passed\": " << (r.passed ? "true" : "false")
+             << ", \"forward_ns_per_bone\": " << r.forwardNsPerBone << ", \"seek_ns_per_bone\": " << r.seekNsPerBone
+             << ", \"characters_per_second\": {";
+        for (size_t t = 0; t < r.throughput.size(); t++)
+            file << (t ? ", " : "") << "\"" << r.throughput[t].first << "\": " << r.throughput[t].second;
+        file << "} }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ],\n  \"skinning\": [\n";
+    for (size_t i = 0; i < skins.size(); i++)
+    {
+        const SkinResult& r = skins[i];
+        file << "    { \"name\": \"" << r.name << "\", \"vertices\": " << r.vertices << ", \"poses\": " << r.poses
+             << ", \"max_error\": " << r.maxError << ", \"passed\": " << (r.passed ? "true" : "false")
+             << ", \"ns_per_vertex\": " << r.nsPerVertex << ", \"reference_ns_per_vertex\": " << r.referenceNsPerVertex
+             << " }" << (i + 1 < skins.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    std::string jsonPath;
+    std::vector<std::string> assets;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc)
+            options.samples = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--characters" && i + 1 < argc)
+            options.characters = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--frames" && i + 1 < argc)
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc)
+            options.threads = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--tolerance" && i + 1 < argc)
+            options.tolerance = std::atof(argv[++i]);
+        else if (arg == "--clip-tolerance" && i + 1 < argc)
+            options.clipTolerance = std::atof(argv[++i]);
+        else if (arg == "--skin-tolerance" && i + 1 < argc)
+            options.skinTolerance = std::atof(argv[++i]);
+        else if (arg == "--compiled")
+            options.compiled = true;
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            assets.push_back(arg);
+    }
+    if (assets.empty())
+        assets.push_back("resources/objects/vampire/dancing_vampire.dae");
+
+    // models upload their meshes while loading; a stub GL lets that run without a context
+    if (!gladLoadGLLoader((GLADloadproc)GLCounter::NullLoader))
+    {
+        std::cout << "Failed to initialize the null GL stub" << std::endl;
+        return -1;
+    }
+
+    std::vector<ClipResult> results;
+    std::vector<SkinResult> skins;
+    bool passed = true;
+    for (const std::string& path : assets)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, 0);
+        if (!scene || scene->mNumAnimations == 0)
+        {
+            std::cout << "ERROR::BENCHMARK: " << path << " is missing or has no animation" << std::endl;
+            passed = false;
+            continue;
+        }
+        importer.FreeScene();
+
+        // the skinning check needs the bind pose vertices on the CPU
+        Model model(path, false, VERTEX_LAYOUT_FULL, CPU_DATA_KEEP);
+        Animation animation(path, &model);
+        results.push_back(run(path, animation, animation, options, options.tolerance));
+        passed = passed && results.back().passed;
+        skins.push_back(checkSkinning(path, model, animation, options));
+        passed = passed && skins.back().passed;
+
+        if (options.compiled)
+        {
+            std::string clipPath = (std::filesystem::temp_directory_path() / "bench_anim.clip").string();
+            AnimationCompiler::Stats stats;
+            Animation compiled;
+            if (!AnimationCompiler::Compile(animation, clipPath, AnimationCompiler::Options(), "", &stats) || !AnimationCompiler::Load(clipPath, compiled))
+            {
+                std::cout << "ERROR::BENCHMARK: could not compile " << path << std::endl;
+                passed = false;
+                continue;
+            }
+            printf("\ncompiled clip: %zu of %zu keys kept, %zu bytes (was %zu)\n", stats.keysOut, stats.keysIn, stats.bytesOut, stats.bytesIn);
+            results.push_back(run(path + " (compiled)", compiled, animation, options, options.clipTolerance));
+            passed = passed && results.back().passed;
+            std::error_code ec;
+            std::filesystem::remove(clipPath, ec);
+        }
+    }
+
+    if (!jsonPath.empty() && !writeJson(jsonPath, results, skins))
+        return -1;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+// Scene graph and frustum culling benchmark and correctness harness. It
+// - culls random boxes with FrustumCuller and checks the kept indices against AABB::isOnFrustum;
+// - builds a random hierarchy in a SceneGraph and checks its world matrices against a chain of
+//   Transform::computeModelMatrix calls, its Cull against AABB::isOnFrustum on those transforms, and
+//   GatherInstances against the visible nodes of each model;
+// - draws the scene with SceneGraph::Draw and DrawInstanced and checks, through GLCounter, that both
+//   draw the same nodes and that DrawInstanced issues one draw per mesh of each model in view;
+// - times each of them next to the reference.
+// GL is stubbed out (GLCounter::NullLoader), so no GPU or display is needed. The exit code is
+// non-zero when any result differs from its reference.
+//
+// usage: bench_cull [options] [model ...]      (default models: resources/objects/rock/rock.obj and
+//                                              resources/objects/planet/planet.obj)
+// --boxes <n>        random boxes for the culler alone, 100000 by default
+// --nodes <n>        nodes in the scene graph, 100000 by default
+// --runs <n>         repetitions of every timed step, 20 by default
+// --tolerance <x>    largest relative world matrix error accepted, 1e-4 by default
+// --seed <n>         seed of the random scene, 1 by default
+// ---------------------------------------------------------------------------------------------------------
+#include <glad/glad.h>
+
+#include "LearnOpenGL/gl_counter.h"
+#include "LearnOpenGL/model.h"
+#include "LearnOpenGL/camera.h"
+#include "LearnOpenGL/entity.h"
+#include "LearnOpenGL/frustum_culler.h"
+#include "LearnOpenGL/scene_graph.h"
+#include "LearnOpenGL/shader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Options
+{
+    size_t boxes = 100000, nodes = 100000;
+    int runs = 20;
+    double tolerance = 1e-4;
+    unsigned int seed = 1;
+};
+
+// milliseconds per call of step, averaged over runs calls
+template<typename Step>
+double timeMs(int runs, Step step)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; r++)
+        step();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+// largest matrix difference, relative to the size of the reference entries
+double compare(const glm::mat4& actual, const glm::mat4& expected)
+{
+    double worst = 0.0;
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+        {
+            double scale = std::max(1.0, std::fabs(static_cast<double>(expected[c][r])));
+            worst = std::max(worst, std::fabs(static_cast<double>(actual[c][r]) - expected[c][r]) / scale);
+        }
+    return worst;
+}
+
+// draw calls counted by GLCounter since the previous call
+unsigned long long drawCalls()
+{
+    GLCounter::EndFrame();
+    unsigned long long calls = 0;
+    for (const auto& entry : GLCounter::LastFrame())
+        calls += entry.second.drawCalls;
+    return calls;
+}
+
+// the camera at the origin looking down -z, seeing about a tenth of the random scene
+Frustum makeFrustum()
+{
+    Camera camera(glm::vec3(0.0f, 0.0f, 0.0f));
+    return createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 150.0f);
+}
+
+// FrustumCuller on its own, against the single box test of BoundingVolume
+bool checkBoxes(const Frustum& frustum, const Options& options, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f), extent(0.1f, 5.0f);
+    std::vector<float> center[3], half[3];
+    for (int k = 0; k < 3; k++)
+    {
+        center[k].resize(options.boxes);
+        half[k].resize(options.boxes);
+    }
+    std::vector<AABB> boxes;
+    boxes.reserve(options.boxes);
+    for (size_t i = 0; i < options.boxes; i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            center[k][i] = position(random);
+            half[k][i] = extent(random);
+        }
+        boxes.emplace_back(glm::vec3(center[0][i], center[1][i], center[2][i]), half[0][i], half[1][i], half[2][i]);
+    }
+
+    FrustumCuller culler(frustum);
+    std::vector<unsigned int> visible, expected;
+    auto cull = [&] {
+        culler.Cull(center[0].data(), center[1].data(), center[2].data(), half[0].data(), half[1].data(), half[2].data(),
+                    options.boxes, visible);
+    };
+    auto reference = [&] {
+        expected.clear();
+        for (size_t i = 0; i < boxes.size(); i++)
+            if (static_cast<const BoundingVolume&>(boxes[i]).isOnFrustum(frustum))
+                expected.push_back(static_cast<unsigned int>(i));
+    };
+    double cullMs = timeMs(options.runs, cull), referenceMs = timeMs(options.runs, reference);
+
+    bool passed = visible == expected;
+    printf("boxes: %zu of %zu visible (reference %zu) %s\n", visible.size(), options.boxes, expected.size(), passed ? "ok" : "MISMATCH");
+    printf("  FrustumCuller::Cull %8.3f ms   AABB::isOnFrustum %8.3f ms   (%.1fx)\n", cullMs, referenceMs, referenceMs / cullMs);
+    return passed;
+}
+
+// a random hierarchy drawn with models, as a SceneGraph and as one Transform per node
+bool checkScene(const Frustum& frustum, const std::vector<std::unique_ptr<Model>>& models, const Options& options, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f), offset(-5.0f, 5.0f), angle(-180.0f, 180.0f), size(0.5f, 1.5f);
+    SceneGraph scene;
+    std::vector<SceneGraph::NodeId> ids;
+    std::vector<int> parents;                 // per node in creation order, -1 for roots
+    std::vector<const Model*> nodeModels;     // null for transform only nodes
+    std::vector<Transform> transforms(options.nodes);
+    for (size_t i = 0; i < options.nodes; i++)
+    {
+        // one node in ten is a root, so later roots also exercise the depth sort
+        int parent = i == 0 || random() % 10 == 0 ? -1 : static_cast<int>(random() % i);
+        Model* model = random() % 8 == 0 ? nullptr : models[random() % models.size()].get();
+        SceneGraph::NodeId id = scene.AddNode(parent < 0 ? SceneGraph::INVALID_NODE : ids[parent], model);
+        glm::vec3 local = parent < 0 ? glm::vec3(position(random), position(random), position(random))
+                                     : glm::vec3(offset(random), offset(random), offset(random));
+        glm::vec3 rotation(angle(random), angle(random), angle(random)), scale(size(random), size(random), size(random));
+        scene.SetLocalPosition(id, local);
+        scene.SetLocalRotation(id, rotation);
+        scene.SetLocalScale(id, scale);
+        transforms[i].setLocalPosition(local);
+        transforms[i].setLocalRotation(rotation);
+        transforms[i].setLocalScale(scale);
+        ids.push_back(id);
+        parents.push_back(parent);
+        nodeModels.push_back(model);
+    }
+
+    // world transforms: parents are created before their children, so one forward pass suffices
+    auto reference = [&] {
+        for (size_t i = 0; i < transforms.size(); i++)
+        {
+            if (parents[i] < 0)
+                transforms[i].computeModelMatrix();
+            else
+                transforms[i].computeModelMatrix(transforms[parents[i]].getModelMatrix());
+        }
+    };
+    double updateMs = timeMs(1, [&] { scene.Update(); });
+    double referenceMs = timeMs(1, reference);
+    double staticMs = timeMs(options.runs, [&] { scene.Update(); });
+    double worst = 0.0;
+    bool passed = true;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        worst = std::max(worst, compare(scene.GetWorldMatrix(ids[i]), transforms[i].getModelMatrix()));
+        SceneGraph::NodeId parent = parents[i] < 0 ? SceneGraph::INVALID_NODE : ids[parents[i]];
+        passed = passed && scene.GetParent(ids[i]) == parent;
+    }
+    passed = passed && worst <= options.tolerance;
+    printf("scene graph: %zu nodes, largest world matrix error %.3g %s\n", ids.size(), worst, passed ? "ok" : "MISMATCH");
+    printf("  SceneGraph::Update %8.3f ms   Transform chain %8.3f ms   unchanged scene %8.3f ms\n", updateMs, referenceMs, staticMs);
+
+    // culling, compared by node; Cull returns array indices in depth order
+    std::vector<unsigned int> visible;
+    std::vector<unsigned char> expected(ids.size(), 0);
+    size_t expectedCount = 0;
+    double cullMs = timeMs(options.runs, [&] { scene.Cull(frustum, visible); });
+    double boxMs = timeMs(options.runs, [&] {
+        expectedCount = 0;
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            expected[ids[i]] = nodeModels[i] && generateAABB(*nodeModels[i]).isOnFrustum(frustum, transforms[i]);
+            expectedCount += expected[ids[i]];
+        }
+    });
+    std::vector<unsigned char> culled(ids.size(), 0);
+    for (unsigned int index : visible)
+        culled[scene.GetNode(index)] = 1;
+    bool culledMatch = culled == expected;
+    printf("culling: %zu of %zu nodes visible (reference %zu) %s\n", visible.size(), ids.size(), expectedCount, culledMatch ? "ok" : "MISMATCH");
+    printf("  SceneGraph::Cull %8.3f ms   AABB::isOnFrustum %8.3f ms   (%.1fx)\n", cullMs, boxMs, boxMs / cullMs);
+
+    // instances: the visible nodes of each model with their world matrices, in the order Cull returned them
+    std::vector<size_t> nodeOf(ids.size());
+    for (size_t i = 0; i < ids.size(); i++)
+        nodeOf[ids[i]] = i;
+    bool instancesMatch = true;
+    std::vector<glm::mat4> matrices;
+    double gatherMs = timeMs(options.runs, [&] {
+        for (const std::unique_ptr<Model>& model : models)
+            scene.GatherInstances(visible, model.get(), matrices);
+    });
+    for (const std::unique_ptr<Model>& model : models)
+    {
+        scene.GatherInstances(visible, model.get(), matrices);
+        size_t next = 0;
+        for (unsigned int index : visible)
+        {
+            SceneGraph::NodeId id = scene.GetNode(index);
+            if (nodeModels[nodeOf[id]] != model.get())
+                continue;
+            instancesMatch = instancesMatch && next < matrices.size() && matrices[next] == scene.GetWorldMatrix(id);
+            next++;
+        }
+        instancesMatch = instancesMatch && next == matrices.size();
+    }
+    printf("instances: %s, SceneGraph::GatherInstances %.3f ms for %zu models\n", instancesMatch ? "ok" : "MISMATCH", gatherMs, models.size());
+
+    // drawing: a draw per mesh of every visible node, against a draw per mesh of every model in view
+    Shader shader("resources/shaders/instanced_model.vs", "resources/shaders/instanced_model.fs");
+    size_t expectedPerNode = 0, expectedInstanced = 0;
+    for (unsigned int index : visible)
+        expectedPerNode += nodeModels[nodeOf[scene.GetNode(index)]]->meshes.size();
+    for (const std::unique_ptr<Model>& model : models)
+    {
+        scene.GatherInstances(visible, model.get(), matrices);
+        expectedInstanced += matrices.empty() ? 0 : model->meshes.size();
+    }
+    unsigned int perNodeDisplay = 0, perNodeTotal = 0, instancedDisplay = 0, instancedTotal = 0;
+    drawCalls();
+    scene.Draw(frustum, shader, perNodeDisplay, perNodeTotal);
+    unsigned long long perNodeCalls = drawCalls();
+    scene.DrawInstanced(frustum, shader, instancedDisplay, instancedTotal);
+    unsigned long long instancedCalls = drawCalls();
+    bool drawMatch = perNodeDisplay == visible.size() && instancedDisplay == visible.size() && perNodeTotal == instancedTotal &&
+                     perNodeCalls == expectedPerNode && instancedCalls == expectedInstanced;
+    unsigned int display = 0, total = 0;
+    double drawMs = timeMs(options.runs, [&] { scene.Draw(frustum, shader, display, total); });
+    double instancedMs = timeMs(options.runs, [&] { scene.DrawInstanced(frustum, shader, display, total); });
+    drawCalls();
+    printf("drawing: %u nodes, %llu draw calls one node at a time, %llu instanced (expected %zu and %zu) %s\n", instancedDisplay,
+           perNodeCalls, instancedCalls, expectedPerNode, expectedInstanced, drawMatch ? "ok" : "MISMATCH");
+    printf("  SceneGraph::Draw %8.3f ms   SceneGraph::DrawInstanced %8.3f ms (null GL, CPU side only)\n", drawMs, instancedMs);
+    return passed && culledMatch && instancesMatch && drawMatch;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--boxes" && i + 1 < argc)
+            options.boxes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--nodes" && i + 1 < argc)
+            options.nodes = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--runs" && i + 1 < argc)
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--tolerance" && i + 1 < argc)
+            options.tolerance = std::atof(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            options.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else
+            paths.push_back(arg);
+    }
+    if (paths.empty())
+        paths = { "resources/objects/rock/rock.obj", "resources/objects/planet/planet.obj" };
+
+    // models upload their meshes while loading; a stub GL lets that run without a context
+    if (!gladLoadGLLoader((GLADloadproc)GLCounter::NullLoader))
+    {
+        std::cout << "Failed to initialize the null GL stub" << std::endl;
+        return -1;
+    }
+    GLCounter::Install();
+
+    std::vector<std::unique_ptr<Model>> models;
+    for (const std::string& path : paths)
+    {
+        models.push_back(std::make_unique<Model>(path));
+        if (models.back()->meshes.empty())
+        {
+            std::cout << "ERROR::BENCHMARK: " << path << " could not be loaded" << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937 random(options.seed);
+    Frustum frustum = makeFrustum();
+    bool passed = checkBoxes(frustum, options, random);
+    passed = checkScene(frustum, models, options, random) && passed;
+    printf("\n%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
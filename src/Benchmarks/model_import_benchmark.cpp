@@ -0,0 +1,339 @@
+// Model import benchmark: loads every model under resources/objects a number of times and reports
+// where the time goes (see LoadProfile), how much it allocates and the memory high-water marks.
+// It also reports the simulated vertex cache statistics of each import (MeshOptimizer::Report); the
+// exit code is non-zero when optimization left an asset's ACMR or ATVR worse than before.
+//
+// command line options
+// --runs <n>        loads per asset, 3 by default
+// --assets <dir>    directory searched recursively for model files, resources/objects by default
+// --filter <text>   only assets whose path contains text
+// --json <file>     write the results as JSON, for comparing runs across commits
+// --label <text>    free-form tag stored in the JSON (e.g. the commit hash)
+// --null-gl         stub out GL (no GPU needed); uploads then only measure the CPU side
+// --cache           allow the compiled model cache; by default every load is a full import
+// ---------------------------------------------------------------------------------------------------------
+#include <glad/glad.h>
+
+#include "LearnOpenGL/gl_counter.h"
+#include "LearnOpenGL/headless_context.h"
+#include "LearnOpenGL/load_profile.h"
+#include "LearnOpenGL/model.h"
+#include "LearnOpenGL/texture_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// global allocation counters
+// ------------------------------------------------------------------------
+// every operator new goes through here; a 16-byte header remembers the size so the live heap size
+// (and its high-water mark) can be tracked without relying on malloc_usable_size
+namespace allocations
+{
+    std::atomic<unsigned long long> count{ 0 }, bytes{ 0 };
+    std::atomic<long long> live{ 0 }, peak{ 0 };
+    const size_t HEADER = 16;
+
+    void* allocate(size_t size)
+    {
+        char* block = static_cast<char*>(std::malloc(size + HEADER));
+        if (!block)
+            throw std::bad_alloc();
+        *reinterpret_cast<size_t*>(block) = size;
+        count++;
+        bytes += size;
+        long long now = live += static_cast<long long>(size);
+        for (long long high = peak.load(); now > high && !peak.compare_exchange_weak(high, now); )
+            ;
+        return block + HEADER;
+    }
+
+    void release(void* pointer)
+    {
+        if (!pointer)
+            return;
+        char* block = static_cast<char*>(pointer) - HEADER;
+        live -= static_cast<long long>(*reinterpret_cast<size_t*>(block));
+        std::free(block);
+    }
+}
+
+void* operator new(size_t size) { return allocations::allocate(size); }
+void* operator new[](size_t size) { return allocations::allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocations::allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocations::allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* pointer) noexcept { allocations::release(pointer); }
+void operator delete[](void* pointer) noexcept { allocations::release(pointer); }
+void operator delete(void* pointer, size_t) noexcept { allocations::release(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { allocations::release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { allocations::release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { allocations::release(pointer); }
+
+// resident set high-water mark of the process, in bytes
+size_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+#endif
+}
+
+struct Run
+{
+    double seconds;
+    double stages[LoadProfile::STAGES];
+    unsigned long long allocations, allocatedBytes;
+    long long peakHeapBytes; // above the live heap before the load
+};
+
+struct AssetResult
+{
+    std::string path;
+    size_t meshes = 0, vertices = 0, triangles = 0, textures = 0;
+    std::vector<Run> runs;
+    MeshOptimizer::Report optimization; // of the last run; empty when it came from the model cache
+};
+
+std::vector<std::string> findAssets(const std::string &directory, const std::string &filter);
+Run loadOnce(const std::string &path, AssetResult &asset);
+bool optimizationHelped(const AssetResult &asset);
+void printSummary(const AssetResult &asset);
+bool writeJson(const std::string &path, const std::vector<AssetResult> &results, int runs, bool nullGL, bool cache, const std::string &label);
+
+int main(int argc, char *argv[])
+{
+    std::string assetDir = "resources/objects", filter, jsonPath, label;
+    int runs = 3;
+    bool nullGL = false, cache = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--assets" && i + 1 < argc)
+            assetDir = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (arg == "--label" && i + 1 < argc)
+            label = argv[++i];
+        else if (arg == "--null-gl")
+            nullGL = true;
+        else if (arg == "--cache")
+            cache = true;
+    }
+    // without --cache every run is a full import, whatever LOGL_MODEL_CACHE says
+    if (!cache)
+        ModelCache::SetDirectory("");
+
+    HeadlessContext context;
+    if (!nullGL && !context.Create(3, 3))
+    {
+        std::cout << "no OpenGL context available, falling back to --null-gl" << std::endl;
+        nullGL = true;
+    }
+    if (nullGL && !gladLoadGLLoader((GLADloadproc)GLCounter::NullLoader))
+    {
+        std::cout << "Failed to initialize the null GL stub" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> assets = findAssets(assetDir, filter);
+    if (assets.empty())
+    {
+        std::cout << "ERROR::BENCHMARK: no model files under " << assetDir << std::endl;
+        return -1;
+    }
+    printf("%zu assets, %d runs each, %s GL, model cache %s\n", assets.size(), runs, nullGL ? "null" : "real", cache ? "on" : "off");
+
+    LoadProfile profile;
+    LoadProfile::Install(&profile);
+    std::vector<AssetResult> results;
+    bool passed = true;
+    for (const std::string &path : assets)
+    {
+        AssetResult asset;
+        asset.path = path;
+        for (int run = 0; run < runs; ++run)
+        {
+            profile.Reset();
+            asset.runs.push_back(loadOnce(path, asset));
+            for (int stage = 0; stage < LoadProfile::STAGES; ++stage)
+                asset.runs.back().stages[stage] = profile.Seconds(static_cast<LoadProfile::Stage>(stage));
+        }
+        printSummary(asset);
+        passed = optimizationHelped(asset) && passed;
+        results.push_back(asset);
+    }
+    LoadProfile::Install(nullptr);
+    printf("peak resident set: %.1f MB\n", peakResidentBytes() / (1024.0 * 1024.0));
+
+    if (!jsonPath.empty() && !writeJson(jsonPath, results, runs, nullGL, cache, label))
+        return -1;
+    context.Destroy();
+    return passed ? 0 : 1;
+}
+
+std::vector<std::string> findAssets(const std::string &directory, const std::string &filter)
+{
+    Assimp::Importer importer;
+    std::vector<std::string> assets;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        if (!it->is_regular_file())
+            continue;
+        std::string path = it->path().generic_string();
+        if (importer.IsExtensionSupported(it->path().extension().string()) && path.find(filter) != std::string::npos)
+            assets.push_back(path);
+    }
+    std::sort(assets.begin(), assets.end());
+    return assets;
+}
+
+Run loadOnce(const std::string &path, AssetResult &asset)
+{
+    // textures released by the previous run would otherwise come straight from the cache
+    TextureCache::Shared().Trim();
+
+    Run run = {};
+    unsigned long long allocationsBefore = allocations::count, bytesBefore = allocations::bytes;
+    long long liveBefore = allocations::live;
+    allocations::peak = liveBefore;
+    auto start = std::chrono::steady_clock::now();
+    {
+        Model model(path);
+        glFinish();
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        asset.meshes = model.meshes.size();
+        asset.vertices = asset.triangles = 0;
+        for (const Mesh &mesh : model.meshes)
+        {
+            asset.vertices += mesh.vertexCount;
+            asset.triangles += mesh.lods[0].indexCount / 3;
+        }
+        asset.textures = model.textures_loaded.size();
+        asset.optimization = model.optimization;
+    }
+    run.allocations = allocations::count - allocationsBefore;
+    run.allocatedBytes = allocations::bytes - bytesBefore;
+    run.peakHeapBytes = allocations::peak - liveBefore;
+    return run;
+}
+
+void printSummary(const AssetResult &asset)
+{
+    std::vector<double> totals;
+    double stages[LoadProfile::STAGES] = {};
+    for (const Run &run : asset.runs)
+    {
+        totals.push_back(run.seconds);
+        for (int stage = 0; stage < LoadProfile::STAGES; ++stage)
+            stages[stage] += run.stages[stage] / asset.runs.size();
+    }
+    std::sort(totals.begin(), totals.end());
+    const Run &last = asset.runs.back();
+    printf("\n%s: %zu meshes, %zu vertices, %zu triangles, %zu textures\n", asset.path.c_str(), asset.meshes, asset.vertices, asset.triangles, asset.textures);
+    printf("  total    min %8.2f ms  median %8.2f ms  max %8.2f ms\n", totals.front() * 1e3, totals[totals.size() / 2] * 1e3, totals.back() * 1e3);
+    for (int stage = 0; stage < LoadProfile::STAGES; ++stage)
+        printf("  %-16s %8.2f ms (mean)\n", LoadProfile::Name(static_cast<LoadProfile::Stage>(stage)), stages[stage] * 1e3);
+    printf("  allocations %llu (%.1f MB), peak heap +%.1f MB\n", last.allocations, last.allocatedBytes / (1024.0 * 1024.0), last.peakHeapBytes / (1024.0 * 1024.0));
+    if (asset.optimization.triangles == 0)
+        printf("  vertex cache: no import statistics (loaded from the model cache)\n");
+    else
+        asset.optimization.Print(asset.path);
+}
+
+// the simulated vertex cache must not do worse after optimization than before. ATVR divides by the
+// vertex count, which welding shrinks (imports are not welded by ASSIMP, so ATVR starts near 1); both
+// sides are therefore taken over the welded vertices, so a smaller mesh does not count as a worse cache.
+bool optimizationHelped(const AssetResult &asset)
+{
+    const MeshOptimizer::Report &report = asset.optimization;
+    if (report.triangles == 0)
+        return true;
+    double acmrBefore = report.missesBefore / report.triangles, acmrAfter = report.missesAfter / report.triangles;
+    double atvrBefore = report.missesBefore / report.verticesAfter, atvrAfter = report.missesAfter / report.verticesAfter;
+    bool helped = acmrAfter <= acmrBefore && atvrAfter <= atvrBefore;
+    if (!helped)
+        std::cout << "ERROR::BENCHMARK: " << asset.path << ": optimization made the vertex cache worse, ACMR " << acmrBefore << " -> "
+                  << acmrAfter << ", ATVR over the welded vertices " << atvrBefore << " -> " << atvrAfter << std::endl;
+    return helped;
+}
+
+bool writeJson(const std::string &path, const std::vector<AssetResult> &results, int runs, bool nullGL, bool cache, const std::string &label)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::BENCHMARK: could not open " << path << std::endl;
+        return false;
+    }
+    auto quoted = [](const std::string &text) {
+        std::string out = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    };
+    file << "{\n  \"benchmark\": \"model_import\",\n  \"label\": " << quoted(label) << ",\n  \"runs\": " << runs
+         << ",\n  \"gl\": \"" << (nullGL ? "null" : "real") << "\",\n  \"model_cache\": " << (cache ? "true" : "false")
+         << ",\n  \"peak_resident_bytes\": " << peakResidentBytes() << ",\n  \"assets\": [\n";
+    for (size_t a = 0; a < results.size(); ++a)
+    {
+        const AssetResult &asset = results[a];
+        file << "    {\n      \"path\": " << quoted(asset.path) << ", \"meshes\": " << asset.meshes << ", \"vertices\": " << asset.vertices
+             << ", \"triangles\": " << asset.triangles << ", \"textures\": " << asset.textures << ",\n";
+        if (asset.optimization.triangles > 0)
+        {
+            MeshOptimizer::CacheStats before = asset.optimization.Before(), after = asset.optimization.After();
+            file << "      \"vertex_cache\": { \"vertices_before\": " << asset.optimization.verticesBefore
+                 << ", \"vertices_after\": " << asset.optimization.verticesAfter << ", \"acmr_before\": " << before.acmr
+                 << ", \"acmr_after\": " << after.acmr << ", \"atvr_before\": " << before.atvr << ", \"atvr_after\": " << after.atvr << " },\n";
+        }
+        file << "      \"runs\": [\n";
+        for (size_t r = 0; r < asset.runs.size(); ++r)
+        {
+            const Run &run = asset.runs[r];
+            file << "        { \"seconds\": " << run.seconds;
+            for (int stage = 0; stage < LoadProfile::STAGES; ++stage)
+                file << ", \"" << LoadProfile::Name(static_cast<LoadProfile::Stage>(stage)) << "\": " << run.stages[stage];
+            file << ", \"allocations\": " << run.allocations << ", \"allocated_bytes\": " << run.allocatedBytes
+                 << ", \"peak_heap_bytes\": " << run.peakHeapBytes << " }" << (r + 1 < asset.runs.size() ? "," : "") << "\n";
+        }
+        file << "      ]\n    }" << (a + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
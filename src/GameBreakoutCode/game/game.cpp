@@ -43,7 +43,7 @@ void ActivatePowerUp(PowerUp &powerUp);
 bool IsOtherPowerUpActive(std::vector<PowerUp> &powerUps, std::string type);
 
 Game::Game(unsigned int width, unsigned int height)
-    : State(GAME_MENU), Keys(), Width(width), Height(height), Lives(3), PowerUpProbability(75), PowerDownProbability(15)
+    : State(GAME_MENU), Keys(), Width(width), Height(height), Framebuffer(0), Time(0.0f), Lives(3), PowerUpProbability(75), PowerDownProbability(15)
 {
 }
 
@@ -137,6 +137,7 @@ void Game::Init()
 
 void Game::Update(float dt)
 {
+    this->Time += dt;
     // Ball position update
     Ball->Move(dt, this->Width);
     // Ball Collision check
@@ -267,9 +268,9 @@ void Game::Render()
         ss << this->Lives;
         Text->RenderText("Lives:" + ss.str(), 5.0f, 5.0f, 1.0f);
 
-        Effects->EndRender();
+        Effects->EndRender(this->Framebuffer);
         // render postprocessing quad
-        Effects->Render(glfwGetTime());
+        Effects->Render(this->Time);
     }
 
     if (this->State == GAME_MENU)
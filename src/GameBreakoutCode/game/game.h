@@ -55,6 +55,10 @@ public:
     bool Keys[1024];
     GLboolean KeysProcessed[1024];
     unsigned int Width, Height;
+    // framebuffer the final image is drawn into (0 = the window)
+    unsigned int Framebuffer;
+    // game time accumulated by Update, drives the time-based effects
+    float Time;
     std::vector<GameLevel> Levels;
     unsigned int Level;
     // constructor/destructor
@@ -7,8 +7,9 @@
 ** option) any later version.
 ******************************************************************/
 #include "particle_generator.h"
+#include "LearnOpenGL/gl_counter.h"
 
-ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
+ParticleGenerator::ParticleGenerator(Shader &shader, Texture2D texture, unsigned int amount)
     : shader(shader), texture(texture), amount(amount)
 {
     this->init();
@@ -38,6 +39,7 @@ void ParticleGenerator::Update(float dt, GameObject &object, unsigned int newPar
 // render all particles
 void ParticleGenerator::Draw()
 {
+    GLCounter::Scope counterScope("ParticleGenerator");
     // use additive blending to give it a 'glow' effect
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
     this->shader.Use();
@@ -10,7 +10,9 @@
 
 #include <iostream>
 
-PostProcessor::PostProcessor(Shader shader, unsigned int width, unsigned int height) 
+#include "LearnOpenGL/gl_counter.h"
+
+PostProcessor::PostProcessor(Shader &shader, unsigned int width, unsigned int height) 
     : PostProcessingShader(shader), Texture(), Width(width), Height(height), Confuse(false), Chaos(false), Shake(false)
 {
     // initialize renderbuffer/framebuffer object
@@ -63,21 +65,24 @@ PostProcessor::PostProcessor(Shader shader, unsigned int width, unsigned int hei
 
 void PostProcessor::BeginRender()
 {
+    GLCounter::Scope counterScope("PostProcessor");
     glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 }
-void PostProcessor::EndRender()
+void PostProcessor::EndRender(unsigned int target)
 {
+    GLCounter::Scope counterScope("PostProcessor");
     // now resolve multisampled color-buffer into intermediate FBO to store to texture
     glBindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->FBO);
     glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // binds both READ and WRITE framebuffer to default framebuffer
+    glBindFramebuffer(GL_FRAMEBUFFER, target); // binds both READ and WRITE framebuffer to the target framebuffer
 }
 
 void PostProcessor::Render(float time)
 {
+    GLCounter::Scope counterScope("PostProcessor");
     // set uniforms/options
     this->PostProcessingShader.Use();
     this->PostProcessingShader.SetFloat("time", time);
@@ -27,17 +27,18 @@ class PostProcessor
 {
 public:
     // state
-    Shader PostProcessingShader;
+    Shader &PostProcessingShader;
     Texture2D Texture;
     unsigned int Width, Height;
     // options
     bool Confuse, Chaos, Shake;
     // constructor
-    PostProcessor(Shader shader, unsigned int width, unsigned int height);
+    PostProcessor(Shader &shader, unsigned int width, unsigned int height);
     // prepares the postprocessor's framebuffer operations before rendering the game
     void BeginRender();
     // should be called after rendering the game, so it stores all the rendered data into a texture object
-    void EndRender();
+    // and leaves the target framebuffer (0 = the window) bound for Render()
+    void EndRender(unsigned int target = 0);
     // renders the PostProcessor texture quad (as a screen-encompassing large sprite)
     void Render(float time);
 private:
@@ -17,13 +17,23 @@
 // Instantiate static variables
 std::map<std::string, Texture2D> ResourceManager::Textures;
 std::map<std::string, Shader> ResourceManager::Shaders;
+ShaderWatcher ResourceManager::Watcher;
 
 Shader& ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
 {
     Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+    std::vector<ShaderWatcher::Stage> stages = { { GL_VERTEX_SHADER, vShaderFile }, { GL_FRAGMENT_SHADER, fShaderFile } };
+    if (gShaderFile != nullptr)
+        stages.push_back({ GL_GEOMETRY_SHADER, gShaderFile });
+    Watcher.Watch(&Shaders[name].ID, stages);
     return Shaders[name];
 }
 
+void ResourceManager::ReloadShaders()
+{
+    Watcher.Update();
+}
+
 Shader& ResourceManager::GetShader(std::string name)
 {
     return Shaders[name];
@@ -42,6 +52,7 @@ Texture2D& ResourceManager::GetTexture(std::string name)
 
 void ResourceManager::Clear()
 {
+    Watcher.Stop();
     // (properly) delete all shaders
     for (auto iter : Shaders)
         glDeleteProgram(iter.second.ID);
@@ -16,6 +16,7 @@
 
 #include "texture.h"
 #include "shader.h"
+#include "LearnOpenGL/shader_watcher.h"
 
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
@@ -32,6 +33,8 @@ public:
     static Shader& LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name);
     // retrieves a stored sader
     static Shader& GetShader(std::string name);
+    // swaps in shaders whose source files were edited since the last call (hot-reload); call once per frame
+    static void ReloadShaders();
     // loads (and generates) a texture from file
     static Texture2D& LoadTexture(const char *file, bool alpha, std::string name);
     // retrieves a stored texture
@@ -42,6 +45,8 @@ public:
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() {}
+    // watches the source files of every loaded shader; renderers keep references into Shaders, so a swapped ID is picked up directly
+    static ShaderWatcher Watcher;
     // loads and generates a shader from file
     static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr);
     // loads a single texture from file
@@ -10,6 +10,8 @@
 
 #include <iostream>
 
+#include "LearnOpenGL/shader_cache.h"
+
 Shader &Shader::Use()
 {
     glUseProgram(this->ID);
@@ -18,6 +20,11 @@ Shader &Shader::Use()
 
 void Shader::Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource)
 {
+    // reuse a cached program binary when one matches these sources
+    std::string cacheKey = ShaderCache::MakeKey({ vertexSource, fragmentSource, geometrySource });
+    this->ID = ShaderCache::Load(cacheKey);
+    if (this->ID != 0)
+        return;
     unsigned int sVertex, sFragment, gShader;
     // vertex Shader
     sVertex = glCreateShader(GL_VERTEX_SHADER);
@@ -39,12 +46,14 @@ void Shader::Compile(const char *vertexSource, const char *fragmentSource, const
     }
     // shader program
     this->ID = glCreateProgram();
+    ShaderCache::Prepare(this->ID);
     glAttachShader(this->ID, sVertex);
     glAttachShader(this->ID, sFragment);
     if (geometrySource != nullptr)
         glAttachShader(this->ID, gShader);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
+    ShaderCache::Store(this->ID, cacheKey);
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
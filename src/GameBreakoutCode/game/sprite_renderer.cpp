@@ -7,11 +7,12 @@
 ** option) any later version.
 ******************************************************************/
 #include "sprite_renderer.h"
+#include "LearnOpenGL/gl_counter.h"
 
 
 SpriteRenderer::SpriteRenderer(Shader &shader)
+    : shader(shader)
 {
-    this->shader = shader;
     this->initRenderData();
 }
 
@@ -22,6 +23,7 @@ SpriteRenderer::~SpriteRenderer()
 
 void SpriteRenderer::DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
 {
+    GLCounter::Scope counterScope("SpriteRenderer");
     // prepare transformations
     this->shader.Use();
     glm::mat4 model = glm::mat4(1.0f);
@@ -14,12 +14,13 @@
 
 #include "text_renderer.h"
 #include "resource_manager.h"
+#include "LearnOpenGL/gl_counter.h"
 
 
 TextRenderer::TextRenderer(unsigned int width, unsigned int height)
-{
     // load and configure shader
-    this->TextShader = ResourceManager::LoadShader("src/GameBreakoutCode/shaders/text_2d.vs", "src/GameBreakoutCode/shaders/text_2d.frag", nullptr, "text");
+    : TextShader(ResourceManager::LoadShader("src/GameBreakoutCode/shaders/text_2d.vs", "src/GameBreakoutCode/shaders/text_2d.frag", nullptr, "text"))
+{
     this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
     this->TextShader.SetInteger("text", 0);
     // configure VAO/VBO for texture quads
@@ -97,6 +98,7 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
 
 void TextRenderer::RenderText(std::string text, float x, float y, float scale, glm::vec3 color)
 {
+    GLCounter::Scope counterScope("TextRenderer");
     // activate corresponding render state	
     this->TextShader.Use();
     this->TextShader.SetVector3f("textColor", color);
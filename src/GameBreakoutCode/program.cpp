@@ -9,8 +9,16 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include "game/game.h"
 #include "game/resource_manager.h"
+#include "LearnOpenGL/gl_counter.h"
+#include "LearnOpenGL/headless_context.h"
+#include "LearnOpenGL/frame_capture.h"
 #include "../imgui/imgui.h"
 #include "../imgui/imgui_impl_opengl3.h"
 #include "../imgui/imgui_impl_glfw.h"
@@ -18,6 +26,10 @@
 // GLFW function declarations
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
+// runs a fixed number of frames without a window: against an offscreen context, or the null GL stub (no GPU)
+int runHeadless(bool nullGL, int frames, const std::string &statsPath, const std::string &dumpDir, bool rawDumps, bool benchmark);
+// records the GL work of ImGui's renderer backend
+void countImGuiDrawData(const ImDrawData *drawData);
 
 // The Width of the screen
 const unsigned int SCREEN_WIDTH = 800;
@@ -28,6 +40,39 @@ Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
 
 int main(int argc, char *argv[])
 {
+    // command line options
+    // --gl-stats <file>  write per-frame GL call counts (draw calls, state changes, uploads, binds) as JSON
+    // --frames <n>       quit after n frames
+    // --null-gl          run without a window or GPU against a stub GL (CI), 600 frames unless --frames is given
+    // --headless         render offscreen (surfaceless EGL on Linux) at a fixed 60Hz timestep, 60 frames by default
+    // --dump <dir>       headless: write every frame to <dir>/frame_NNNN.png
+    // --raw              headless: dump raw RGBA8 (.rgba) instead of PNG
+    // --benchmark        uncapped throughput: no vsync in a window, no dumps headless; reports frame times
+    // ---------------------------------------------------------------------------------------------------------
+    std::string statsPath, dumpDir;
+    int frameLimit = -1;
+    bool nullGL = false, headless = false, rawDumps = false, benchmark = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--gl-stats" && i + 1 < argc)
+            statsPath = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc)
+            frameLimit = std::atoi(argv[++i]);
+        else if (arg == "--null-gl")
+            nullGL = true;
+        else if (arg == "--headless")
+            headless = true;
+        else if (arg == "--dump" && i + 1 < argc)
+            dumpDir = argv[++i];
+        else if (arg == "--raw")
+            rawDumps = true;
+        else if (arg == "--benchmark")
+            benchmark = true;
+    }
+    if (nullGL || headless)
+        return runHeadless(nullGL, frameLimit >= 0 ? frameLimit : nullGL ? 600 : 60, statsPath, dumpDir, rawDumps, benchmark);
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -51,6 +96,7 @@ int main(int argc, char *argv[])
     glfwSetKeyCallback(window, key_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
+
     // OpenGL configuration
     // --------------------
     glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
@@ -60,6 +106,11 @@ int main(int argc, char *argv[])
     // initialize game
     // ---------------
     Breakout.Init();
+    if (!statsPath.empty())
+    {
+        GLCounter::Install();
+        GLCounter::Open(statsPath);
+    }
 
     // deltaTime variables
     // -------------------
@@ -67,7 +118,9 @@ int main(int argc, char *argv[])
     float lastFrame = 0.0f;
 
     // imgui Code
-    glfwSwapInterval(1); // Enable vsync
+    glfwSwapInterval(benchmark ? 0 : 1); // Enable vsync unless measuring uncapped throughput
+    double benchmarkStart = glfwGetTime();
+    int framesRendered = 0;
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -87,6 +140,10 @@ int main(int argc, char *argv[])
         lastFrame = currentFrame;
         glfwPollEvents();
 
+        // pick up edited shader sources
+        // -----------------------------
+        ResourceManager::ReloadShaders();
+
         // manage user input
         // -----------------
         Breakout.ProcessInput(deltaTime);
@@ -138,9 +195,21 @@ int main(int argc, char *argv[])
             ImGui::End();
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            countImGuiDrawData(ImGui::GetDrawData());
         }
 
         glfwSwapBuffers(window);
+        if (!statsPath.empty())
+            GLCounter::EndFrame();
+        ++framesRendered;
+        if (frameLimit > 0 && --frameLimit == 0)
+            glfwSetWindowShouldClose(window, true);
+    }
+    GLCounter::Close();
+    if (benchmark && framesRendered > 0)
+    {
+        double seconds = glfwGetTime() - benchmarkStart;
+        printf("%d frames in %.3f s: %.3f ms/frame, %.1f fps\n", framesRendered, seconds, 1000.0f * seconds / framesRendered, framesRendered / seconds);
     }
 
     // delete all resources as loaded using the resource manager
@@ -156,6 +225,92 @@ int main(int argc, char *argv[])
     return 0;
 }
 
+int runHeadless(bool nullGL, int frames, const std::string &statsPath, const std::string &dumpDir, bool rawDumps, bool benchmark)
+{
+    HeadlessContext context;
+    FrameCapture capture;
+    if (nullGL)
+    {
+        if (!gladLoadGLLoader((GLADloadproc)GLCounter::NullLoader))
+        {
+            std::cout << "Failed to initialize the null GL stub" << std::endl;
+            return -1;
+        }
+    }
+    else if (!context.Create(3, 3) || !capture.Init(SCREEN_WIDTH, SCREEN_HEIGHT))
+        return -1;
+    const bool dump = !nullGL && !benchmark && !dumpDir.empty();
+    if (dump)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(dumpDir, ec);
+    }
+
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    srand(1); // particles and power-ups draw from rand()
+    Breakout.Init();
+    Breakout.Framebuffer = capture.Framebuffer();
+    GLCounter::Install();
+    if (!statsPath.empty() && !GLCounter::Open(statsPath))
+        return -1;
+
+    // fixed timestep and scripted input (start on the first frame, launch the ball on the second)
+    // so every run renders the same frames
+    const float deltaTime = 1.0f / 60.0f;
+    Breakout.Keys[GLFW_KEY_ENTER] = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        if (frame == 1)
+        {
+            Breakout.Keys[GLFW_KEY_ENTER] = false;
+            Breakout.Keys[GLFW_KEY_SPACE] = true;
+        }
+        Breakout.ProcessInput(deltaTime);
+        Breakout.Update(deltaTime);
+        glBindFramebuffer(GL_FRAMEBUFFER, Breakout.Framebuffer);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        Breakout.Render();
+        if (dump)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "/frame_%04d.%s", frame, rawDumps ? "rgba" : "png");
+            capture.Capture(dumpDir + name);
+        }
+        GLCounter::EndFrame();
+    }
+    capture.Flush();
+    glFinish();
+    if (benchmark && frames > 0)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%d frames in %.3f s: %.3f ms/frame, %.1f fps\n", frames, seconds, 1000.0 * seconds / frames, frames / seconds);
+    }
+    GLCounter::Close();
+    ResourceManager::Clear();
+    capture.Release();
+    return 0;
+}
+
+void countImGuiDrawData(const ImDrawData *drawData)
+{
+    // ImGui's OpenGL backend loads GL through its own gl3w table, which the glad hooks never see;
+    // it issues one upload per vertex/index buffer and a scissor, texture bind and draw per command
+    GLCounter::Stats stats;
+    for (int i = 0; i < drawData->CmdListsCount; ++i)
+    {
+        const ImDrawList *list = drawData->CmdLists[i];
+        stats.bufferUploadBytes += list->VtxBuffer.Size * sizeof(ImDrawVert) + list->IdxBuffer.Size * sizeof(ImDrawIdx);
+        stats.drawCalls += list->CmdBuffer.Size;
+        stats.stateChanges += list->CmdBuffer.Size;
+        stats.textureBinds += list->CmdBuffer.Size;
+    }
+    GLCounter::Add("ImGui", stats);
+}
+
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode)
 {
     // when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
@@ -9,6 +9,7 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/model_streamer.h>
 
 #include <iostream>
 
@@ -94,7 +95,10 @@ int main()
     // ------------------------------------
     Shader ourShader("./src/shaders/color.vs", "./src/shaders/color.fs");
 
-    Model ourModel("./resources/objects/backpack/backpack.obj");
+    // the model streams in while the window keeps rendering: geometry first, then sharper and sharper textures
+    ModelStreamer streamer;
+    std::shared_ptr<StreamedModel> ourModel = streamer.Load("./resources/objects/backpack/backpack.obj");
+    ourModel->OnReady = [](StreamedModel &model) { std::cout << model.Path() << " fully loaded" << std::endl; };
     
     // shader configuration
     // render loop
@@ -111,6 +115,9 @@ int main()
         // -----
         processInput(window);
 
+        // spend at most 4 ms of the frame on uploads
+        streamer.Update(4.0f);
+
         // render
         // ------
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -130,7 +137,8 @@ int main()
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));	// it's a bit too big for our scene, so scale it down
         ourShader.setMat4("model", model);
-        ourModel.Draw(ourShader);
+        if (Model *loaded = ourModel->Get())
+            loaded->Draw(ourShader);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -10,6 +10,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/lod_selector.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_opengl3.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -86,8 +87,9 @@ int main()
     
     // load models
     // -----------
-    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"));
-    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"));
+    // both shaders only read positions and texcoords, so the compact 20-byte vertex format suffices
+    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, VERTEX_LAYOUT_STATIC_COMPACT);
+    Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"), false, VERTEX_LAYOUT_STATIC_COMPACT);
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -128,7 +130,13 @@ int main()
     unsigned int buffer;
     glGenBuffers(1, &buffer);
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+    // refilled every frame with the matrices sorted by level of detail
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_DYNAMIC_DRAW);
+
+    // rocks far away are drawn with a coarser level once its error shrinks below a pixel
+    vector<float> rockLodErrors = rock.LodErrors();
+    LodSelector lodSelector(glm::radians(45.0f), (float)SCR_HEIGHT);
+    InstanceLodBuckets lodBuckets;
 
     for (unsigned int i = 0; i < rock.meshes.size(); i++)
     {
@@ -212,10 +220,26 @@ int main()
         asteroidShader.setInt("texture_diffuse1", 0);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, rock.textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
+        lodBuckets.Build(modelMatrices, amount, camera.Position, lodSelector, rockLodErrors);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (amount > 0)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, amount * sizeof(glm::mat4), lodBuckets.Sorted.data());
         for (unsigned int i = 0; i < rock.meshes.size(); i++)
         {
-            glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, amount);
+            const Mesh &mesh = rock.meshes[i];
+            glBindVertexArray(mesh.VAO);
+            for (unsigned int level = 0; level < lodBuckets.Count.size(); level++)
+            {
+                if (lodBuckets.Count[level] == 0)
+                    continue;
+                // one instanced draw per level, over that level's range of the instance buffer
+                GLsizei vec4Size = sizeof(glm::vec4);
+                size_t first = lodBuckets.First[level] * sizeof(glm::mat4);
+                for (unsigned int column = 0; column < 4; column++)
+                    glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void *)(first + column * vec4Size));
+                const MeshLod &lod = mesh.lods[std::min<size_t>(level, mesh.lods.size() - 1)];
+                glDrawElementsInstanced(GL_TRIANGLES, lod.indexCount, GL_UNSIGNED_INT, (void *)(lod.indexOffset * sizeof(unsigned int)), lodBuckets.Count[level]);
+            }
             glBindVertexArray(0);
         }
 
@@ -8,6 +8,7 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/shader_watcher.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_opengl3.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -105,6 +106,12 @@ int main()
     Shader shaderLightingPass("./src/shaders/ssao.vs", "./src/shaders/ssao_lighting.fs");
     Shader shaderSSAO("./src/shaders/ssao.vs", "./src/shaders/ssao.fs");
     Shader shaderSSAOBlur("./src/shaders/ssao.vs", "./src/shaders/ssao_blur.fs");
+    // hot-reload: edits to the shader files are compiled in the background and swapped in when they link
+    ShaderWatcher shaderWatcher;
+    shaderWatcher.Watch(&shaderGeometryPass.ID, { { GL_VERTEX_SHADER, "./src/shaders/ssao_geometry.vs" }, { GL_FRAGMENT_SHADER, "./src/shaders/ssao_geometry.fs" } });
+    shaderWatcher.Watch(&shaderLightingPass.ID, { { GL_VERTEX_SHADER, "./src/shaders/ssao.vs" }, { GL_FRAGMENT_SHADER, "./src/shaders/ssao_lighting.fs" } });
+    shaderWatcher.Watch(&shaderSSAO.ID, { { GL_VERTEX_SHADER, "./src/shaders/ssao.vs" }, { GL_FRAGMENT_SHADER, "./src/shaders/ssao.fs" } });
+    shaderWatcher.Watch(&shaderSSAOBlur.ID, { { GL_VERTEX_SHADER, "./src/shaders/ssao.vs" }, { GL_FRAGMENT_SHADER, "./src/shaders/ssao_blur.fs" } });
 
     // load models
     // -----------
@@ -264,6 +271,7 @@ int main()
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        shaderWatcher.Update();
 
         // move light position over time
         // lightPos.x = lightPosData[0];
@@ -0,0 +1,324 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/animator.h>
+#include <learnopengl/model_animation.h>
+#include <learnopengl/crowd_animator.h>
+#include <learnopengl/animation_lod.h>
+#include <learnopengl/frustum.h>
+#include <learnopengl/skinning.h>
+#include <imgui/imgui.h>
+#include <imgui/imgui_impl_opengl3.h>
+#include <imgui/imgui_impl_glfw.h>
+#include <iostream>
+#include <memory>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void processInput(GLFWwindow *window);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// camera
+Camera camera(glm::vec3(0.0f, 3.0f, 20.0f));
+float lastX = (float)SCR_WIDTH  / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+const char* glsl_version = "#version 130";
+
+// crowd: a grid of characters playing the same clip, each at its own time
+const int CROWD_SIDE = 32;
+const float CROWD_SPACING = 2.0f;
+const float CHARACTER_RADIUS = 1.2f; // bounds a character around its center, one unit above its feet
+const glm::vec3 HERO_POSITION(0.0f, 0.0f, 6.0f);
+
+int main()
+{
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    // CrowdAnimator keeps the bone palettes in a shader storage buffer, which needs 4.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    if (!CrowdAnimator::Supported())
+    {
+        std::cout << "This demo needs OpenGL 4.3" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile shaders
+    // -------------------------
+    Shader crowdShader(FileSystem::getPath("resources/shaders/crowd_skinning.vs").c_str(),
+                       FileSystem::getPath("resources/shaders/crowd_skinning.fs").c_str());
+    // the hero is pre-skinned, so both of its passes use shaders that know nothing about bones
+    Shader heroShader(FileSystem::getPath("resources/shaders/pre_skinned.vs").c_str(),
+                      FileSystem::getPath("resources/shaders/crowd_skinning.fs").c_str());
+    Shader shadowShader(FileSystem::getPath("resources/shaders/pre_skinned.vs").c_str(),
+                        FileSystem::getPath("resources/shaders/planar_shadow.fs").c_str());
+
+    // load models
+    // -----------
+    Model character(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"));
+    if (character.meshes.empty())
+    {
+        std::cout << "ERROR::CROWD: resources/objects/vampire/dancing_vampire.dae could not be loaded" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    Animation dance(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"), &character);
+
+    // every character gets its own range of the palette buffer; crowd.Update fills all of them at once
+    CrowdAnimator crowd(CROWD_SIDE * CROWD_SIDE);
+    vector<glm::vec3> positions;
+    for (int x = 0; x < CROWD_SIDE; x++)
+    {
+        for (int z = 0; z < CROWD_SIDE; z++)
+        {
+            int index = crowd.Add(&dance);
+            // spread the characters over the clip so they do not dance in lockstep
+            crowd.Get(index).UpdateAnimation(static_cast<float>(rand() % 1000) / 100.0f);
+            positions.push_back(glm::vec3((x - CROWD_SIDE / 2) * CROWD_SPACING, 0.0f, -(z * CROWD_SPACING)));
+        }
+    }
+    AnimationLodSelector lodSelector(glm::radians(45.0f), (float)SCR_HEIGHT);
+
+    // the hero in front of the crowd: skinned once per frame, then drawn as a shadow and lit
+    Animator hero(&dance);
+    ComputeSkinner computeSkinner(FileSystem::getPath("resources/shaders/skinning.cs").c_str());
+    vector<std::unique_ptr<PreSkinnedMesh>> heroMeshes;
+    for (const Mesh& mesh : character.meshes)
+        heroMeshes.push_back(std::make_unique<PreSkinnedMesh>(mesh));
+    // towards the light, shared by the lighting and the shadow projection
+    glm::vec3 lightDirection = glm::normalize(glm::vec3(0.3f, 1.0f, 0.5f));
+    // squashes geometry onto the ground plane y = 0 along the light
+    glm::mat4 flatten(1.0f);
+    flatten[1] = glm::vec4(-lightDirection.x / lightDirection.y, 0.0f, -lightDirection.z / lightDirection.y, 0.0f);
+
+    // imgui
+    glfwSwapInterval(1); // Enable vsync
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    (void)io;
+    // Setup Platform/Renderer backends
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init(glsl_version);
+
+    bool useLod = true;
+    bool skinOnGpu = true;
+    int visibleCharacters = 0;
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        // configure transformation matrices
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        // animate: characters off screen only advance time, far ones sample their clip less often
+        Frustum frustum = createFrustumFromCamera(camera, (float)SCR_WIDTH / (float)SCR_HEIGHT, glm::radians(45.0f), 0.1f, 1000.0f);
+        for (unsigned int i = 0; i < crowd.Count(); i++)
+        {
+            glm::vec3 center = positions[i] + glm::vec3(0.0f, 1.0f, 0.0f);
+            crowd.SetLod(i, useLod ? lodSelector.Select(frustum, camera.Position, center, CHARACTER_RADIUS) : Animator::Lod());
+        }
+        crowd.Update(deltaTime);
+
+        hero.UpdateAnimation(deltaTime);
+        const vector<glm::mat4>& heroBones = hero.GetFinalBoneMatrices();
+        unsigned int heroBoneCount = static_cast<unsigned int>(heroBones.size());
+        if (skinOnGpu)
+        {
+            computeSkinner.SetPalette(heroBones.data(), heroBoneCount);
+            for (const std::unique_ptr<PreSkinnedMesh>& mesh : heroMeshes)
+                computeSkinner.Skin(*mesh);
+            computeSkinner.Finish();
+        }
+        else
+        {
+            for (const std::unique_ptr<PreSkinnedMesh>& mesh : heroMeshes)
+                mesh->SkinOnCpu(heroBones.data(), heroBoneCount);
+        }
+
+        // render
+        // ------
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        crowdShader.use();
+        crowdShader.setMat4("projection", projection);
+        crowdShader.setMat4("view", view);
+        crowdShader.setVec3("lightDirection", lightDirection);
+        crowd.Bind(0);
+        visibleCharacters = 0;
+        for (unsigned int i = 0; i < crowd.Count(); i++)
+        {
+            if (!crowd.Get(i).GetLod().visible)
+                continue;
+            // one palette buffer for the whole crowd: a draw only moves to its character's bones
+            crowdShader.setInt("paletteOffset", crowd.PaletteOffset(i));
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+            model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f));
+            crowdShader.setMat4("model", model);
+            character.Draw(crowdShader);
+            visibleCharacters++;
+        }
+        // the palettes of this frame may be overwritten once the GPU is done with these draws
+        crowd.EndFrame();
+
+        // hero, pass 1: its shadow, blended over whatever lies beneath
+        glm::mat4 heroModel = glm::translate(glm::mat4(1.0f), HERO_POSITION);
+        heroModel = glm::scale(heroModel, glm::vec3(0.5f, 0.5f, 0.5f));
+        shadowShader.use();
+        shadowShader.setMat4("projection", projection);
+        shadowShader.setMat4("view", view);
+        shadowShader.setMat4("model", flatten * heroModel);
+        shadowShader.setFloat("shadowStrength", 0.5f);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        for (const std::unique_ptr<PreSkinnedMesh>& mesh : heroMeshes)
+            mesh->Draw();
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+
+        // hero, pass 2: lit, from the same skinned vertices
+        heroShader.use();
+        heroShader.setMat4("projection", projection);
+        heroShader.setMat4("view", view);
+        heroShader.setMat4("model", heroModel);
+        heroShader.setVec3("lightDirection", lightDirection);
+        MaterialBindings::Resolve(heroShader.ID);
+        for (unsigned int i = 0; i < heroMeshes.size(); i++)
+        {
+            character.meshes[i].material.Bind();
+            heroMeshes[i]->Draw();
+        }
+
+        // imgui
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+        ImGui::Begin("crowd");
+        ImGui::Text("%d of %u characters drawn", visibleCharacters, crowd.Count());
+        ImGui::Checkbox("animation lod", &useLod);
+        ImGui::Checkbox("skin hero on GPU", &skinOnGpu);
+        ImGui::End();
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+        glfwPollEvents();
+        glfwSwapBuffers(window);
+    }
+
+    // Cleanup  imgui
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+
+    glfwTerminate();
+    return 0;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}